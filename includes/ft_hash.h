@@ -0,0 +1,136 @@
+#ifndef FT_HASH_H
+# define FT_HASH_H
+
+# include <stddef.h>
+# include <stdint.h>
+
+/**
+ * Number of independent messages hashed together by the multi-lane kernels.
+ */
+# define MB_LANES 4
+
+/**
+ * Structure representing the four 32-bit words of the MD5 algorithm state.
+ * These words are used in the processing of each 512-bit message block.
+ */
+typedef struct	md5_group_s
+{
+	uint32_t	A;
+	uint32_t	B;
+	uint32_t	C;
+	uint32_t	D;
+}				md5_group_t;
+
+/**
+ * Structure holding the state of a streaming MD5 computation:
+ * the four state words, the pending partial block and the total length.
+ */
+typedef struct	md5_ctx_s
+{
+	md5_group_t		state;
+	uint64_t		length;
+	unsigned char	buffer[64];
+}				md5_ctx_t;
+
+/**
+ * Structure to hold SHA256 computation state.
+ */
+typedef struct	sha256_group_s
+{
+	uint32_t state[8];
+	uint64_t count;
+	unsigned char buffer[64];
+}				sha256_group_t;
+
+/**
+ * Structure representing the Whirlpool hashing context.
+ * This structure holds the internal state of the Whirlpool hash computation,
+ * including the current hash value, a message buffer for processing,
+ * and the total length of the processed data.
+ */
+typedef struct	whirlpool_ctx
+{
+	uint64_t		hash[8];						/* 512-bit algorithm internal hashing state */
+	unsigned char	message[64];					/* 512-bit buffer to hash */
+	uint64_t		length;							/* number of processed bytes */
+}				whirlpool_ctx;
+
+/**
+ * Streaming context able to hold the state of any supported algorithm.
+ */
+typedef union	hash_ctx_u
+{
+	md5_ctx_t		md5;
+	sha256_group_t	sha256;
+	whirlpool_ctx	whirlpool;
+}				hash_ctx_t;
+
+/**
+ * Multi-lane compression function: processes one 64-byte block for each of
+ * the MB_LANES lanes, whose state words are interleaved (state[word][lane]).
+ */
+typedef void	(*compress_mb_t)(uint32_t (*state)[MB_LANES], const uint8_t **blocks);
+
+/**
+ * Multi-lane SHA256 compression on a block given as interleaved big-endian
+ * words (words[word][lane]).
+ */
+typedef void	(*compress_mb_words_t)(uint32_t (*state)[MB_LANES], const uint32_t (*words)[MB_LANES]);
+
+/**
+ * Single-block SHA256 compression on the 16 big-endian words of a block.
+ */
+typedef void	(*sha256_compress_t)(uint32_t *state, const uint32_t *words);
+
+/**
+ * A set of compression kernels built for one instruction set.
+ * One of them is selected at startup from the features of the CPU, or forced
+ * with --impl or FT_SSL_IMPL (see src/dispatch.c); 'lanes' names the
+ * instruction set of the multi-lane kernels of the set.
+ */
+typedef struct	hash_impl_s
+{
+	const char			*name;
+	const char			*lanes;
+	int					(*supported)(void);
+	compress_mb_t		md5_compress_mb;
+	sha256_compress_t	sha256_compress;
+	compress_mb_words_t	sha256_compress_mb_words;
+}				hash_impl_t;
+
+/* The selected kernels */
+extern const hash_impl_t	*hash_impl;
+
+// Dispatch
+int		impl_select(const char *name);
+
+// MD5
+void	md5_init(md5_ctx_t *ctx);
+void	md5_update(md5_ctx_t *ctx, const uint8_t *msg, size_t size);
+void	md5_final(md5_ctx_t *ctx, uint8_t *digest);
+void	md5_oneblock(const uint8_t *msg, size_t len, uint8_t *digest);
+void	md5_compress_mb(uint32_t state[4][MB_LANES], const uint8_t *blocks[MB_LANES]);
+void	md5_compress_mb_scalar(uint32_t state[4][MB_LANES], const uint8_t *blocks[MB_LANES]);
+void	md5_compress_mb_sse2(uint32_t state[4][MB_LANES], const uint8_t *blocks[MB_LANES]);
+void	md5_final_mb(const md5_ctx_t *ctx, const uint8_t **msgs, const size_t *lens, uint8_t **digests, int count);
+
+// SHA256
+void	sha256_init_blocks(sha256_group_t *p);
+void	sha256_update(sha256_group_t *p, const uint8_t *original_msg, size_t size);
+void	sha256_final(sha256_group_t *p, uint8_t *hashed);
+void	sha256_oneblock(const uint8_t *msg, size_t len, uint8_t *digest);
+void	sha256_compress_mb(uint32_t state[8][MB_LANES], const uint8_t *blocks[MB_LANES]);
+void	sha256_compress_mb_words(uint32_t state[8][MB_LANES], const uint32_t words[16][MB_LANES]);
+void	sha256_compress_scalar(uint32_t *state, const uint32_t *words);
+void	sha256_compress_shani(uint32_t *state, const uint32_t *words);
+void	sha256_compress_mb_words_scalar(uint32_t state[8][MB_LANES], const uint32_t words[16][MB_LANES]);
+void	sha256_compress_mb_words_sse2(uint32_t state[8][MB_LANES], const uint32_t words[16][MB_LANES]);
+void	sha256_final_mb(const sha256_group_t *p, const uint8_t **msgs, const size_t *lens, uint8_t **digests, int count);
+
+// WHIRLPOOL
+void	whirlpool_init(whirlpool_ctx *ctx);
+void	whirlpool_update(whirlpool_ctx *ctx, const unsigned char *msg, size_t size);
+void	whirlpool_final(whirlpool_ctx *ctx, unsigned char *result);
+void	whirlpool_oneblock(const uint8_t *msg, size_t len, uint8_t *digest);
+
+#endif
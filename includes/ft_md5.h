@@ -1,6 +1,16 @@
 #ifndef FT_MD5_H
 # define FT_MD5_H
 
+/**
+ * Defines the size of the MD5 digest output in bytes.
+ */
+# define MD5_DIGEST_SIZE 16
+
+/**
+ * Longest message whose padding still fits in a single 64-byte block.
+ */
+# define MD5_ONEBLOCK_MAX 55
+
 /**
  * Array of per-round shift amounts used in the MD5 algorithm.
  */
@@ -32,18 +42,6 @@ static const uint32_t k[] = {
 	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
 	0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
 
-/**
- * Structure representing the four 32-bit words of the MD5 algorithm state.
- * These words are used in the processing of each 512-bit message block.
- */
-typedef struct	md5_group_s
-{
-	uint32_t	A;
-	uint32_t	B;
-	uint32_t	C;
-	uint32_t	D;
-}				md5_group_t;
-
 /**
  * MD5 auxiliary function F.
  * Performs a bitwise operation on three 32-bit words.
@@ -75,4 +73,11 @@ typedef struct	md5_group_s
  */
 #define LEFTROTATE(x, c) (((x) << (c)) | ((x) >> (32 - (c))))
 
+/**
+ * One MD5 step: mixes message word 'w' into 'a' with the auxiliary function
+ * 'f'. Works on plain words as well as on vectors of lanes.
+ */
+#define MD5_STEP(f, a, b, c, d, w, i) \
+	(a = b + LEFTROTATE((a + f(b, c, d) + k[i] + w), r[i]))
+
 #endif
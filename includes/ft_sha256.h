@@ -25,6 +25,11 @@
  */
 #define SHA256_DIGEST_SIZE 32
 
+/**
+ * Longest message whose padding still fits in a single 64-byte block.
+ */
+#define SHA256_ONEBLOCK_MAX 55
+
 /**
  * SHA256 functions for bitwise operations during hashing.
  * These functions are used in the message schedule of the SHA256 algorithm.
@@ -63,16 +68,6 @@
  */
 #define R(i) h(i) += S1(e(i)) + Ch(e(i),f(i),g(i)) + K[i+j] + (j?blk2(i):blk0(i)); d(i) += h(i); h(i) += S0(a(i)) + Maj(a(i), b(i), c(i))
 
-/**
- * Structure to hold SHA256 computation state.
- */
-typedef struct	sha256_group_s
-{
-	uint32_t state[8];
-	uint64_t count;
-	unsigned char buffer[64];
-}				sha256_group_t;
-
 /**
  * SHA256 constant table.
  * Derived from the cube roots of the first 64 primes 2..311.
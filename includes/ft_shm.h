@@ -0,0 +1,69 @@
+#ifndef FT_SHM_H
+# define FT_SHM_H
+
+# include <stdint.h>
+
+/**
+ * Shared-memory transport of the serve daemon.
+ *
+ * A client creates a memfd sealed with F_SEAL_SHRINK, lays out an
+ * shm_header_t at offset 0, a submission ring, a completion ring and a data
+ * area, then sends the descriptor with SCM_RIGHTS along with a "shm" request
+ * line on the socket. The daemon hashes the data in place and posts digests
+ * to the completion ring; the socket stays open for the whole session.
+ *
+ * Both rings are single-producer single-consumer, indexed by free-running
+ * 32-bit counters masked by 'entries - 1'. The client produces submissions
+ * (sq_tail) and consumes completions (cq_head); the daemon does the reverse.
+ * A side about to sleep sets its *_waiting flag and FUTEX_WAITs on the
+ * counter it expects to move; the other side FUTEX_WAKEs it after publishing
+ * when the flag is set. With SHM_BUSY_POLL the daemon never sleeps.
+ * The client keeps at most 'entries' requests outstanding.
+ */
+
+# define SHM_MAGIC 0x4d485346
+# define SHM_VERSION 1
+# define SHM_MAX_ENTRIES 65536
+
+/* Header flags */
+# define SHM_BUSY_POLL 1
+
+/* Submission: hash 'len' bytes at 'offset' in the data area */
+typedef struct	shm_sqe_s
+{
+	uint64_t	user_data;
+	uint64_t	offset;
+	uint64_t	len;
+	uint32_t	algo;
+	uint32_t	reserved;
+}				shm_sqe_t;
+
+/* Completion: 'status' is 0 or an errno value */
+typedef struct	shm_cqe_s
+{
+	uint64_t	user_data;
+	int32_t		status;
+	uint32_t	digest_size;
+	uint8_t		digest[64];
+}				shm_cqe_t;
+
+/* Header at offset 0 of the region; each counter has its own cache line */
+typedef struct	shm_header_s
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	entries;
+	uint32_t	flags;
+	uint64_t	sq_offset;
+	uint64_t	cq_offset;
+	uint64_t	data_offset;
+	uint64_t	data_size;
+	uint32_t	sq_head __attribute__((aligned(64)));
+	uint32_t	sq_tail __attribute__((aligned(64)));
+	uint32_t	server_waiting;
+	uint32_t	cq_head __attribute__((aligned(64)));
+	uint32_t	cq_tail __attribute__((aligned(64)));
+	uint32_t	client_waiting;
+}				shm_header_t;
+
+#endif
@@ -2,63 +2,300 @@
 # define FT_SSL_H
 
 # include "libft.h"
+# include "ft_hash.h"
 # include <stdio.h>
 # include <stdlib.h>
 # include <string.h>
 # include <stdint.h>
 # include <errno.h>
 # include <fcntl.h>
+# include <pthread.h>
 
 # define MAX_STRINGS 100
 # define MAX_FILES 100
 
+# define ENGINE_QUEUE_SIZE 1024
+# define ENGINE_MAX_THREADS 64
+# define ENGINE_SORT_WINDOW 1024
+# define ENGINE_DISK_ORDER 1
+# define ENGINE_PREFETCH_CHUNK 1048576
+# define ENGINE_PREFETCH_MAX 8388608
+# define WALK_DENTS_SIZE 32768
+# define WALK_STAT 1
+# define FILE_LIST_CHUNK 65536
+# define MAX_DIGEST_SIZE 64
+# define DEDUP_PARTIAL_SIZE 4096
+# define STORE_CHUNK_SIZE 1048576
+# define FILE_CHUNK_SIZE 262144
+# define OUTPUT_BUFFER_SIZE 65536
+# define BASE64_SIZE(n) (((n) + 2) / 3 * 4)
+
+# define ENCODING_HEX 0
+# define ENCODING_BINARY 1
+# define ENCODING_BASE64 2
+
+# define INDEX_MAGIC "FTSSLIDX"
+# define INDEX_VERSION 1
+# define INDEX_BLOOM_BITS 16
+# define INDEX_BLOOM_HASHES 7
+# define INDEX_SCAN_LIMIT 8
+
+/* Pointer to hash function */
+typedef char *(*hash_function_t)(uint8_t *, size_t);
+
+/* Pointer to raw digest function, writes the digest in the given buffer */
+typedef void (*digest_function_t)(const uint8_t *, size_t, uint8_t *);
+
+/* Streaming interface over a hash_ctx_t */
+typedef void (*ctx_init_t)(hash_ctx_t *);
+typedef void (*ctx_update_t)(hash_ctx_t *, const uint8_t *, size_t);
+typedef void (*ctx_final_t)(hash_ctx_t *, uint8_t *);
+
+/* Multi-lane finish of up to MB_LANES short messages from a shared midstate */
+typedef void (*ctx_final_mb_t)(const hash_ctx_t *, const uint8_t **, const size_t *, uint8_t **, int);
+
+/* Number of message bytes buffered in a context, not compressed yet */
+typedef size_t (*ctx_pending_t)(const hash_ctx_t *);
+
+/* Description of a supported hash algorithm */
+typedef struct	hash_algo_s
+{
+	const char			*name;
+	const char			*label;
+	size_t				digest_size;
+	digest_function_t	digest;
+	ctx_init_t			init;
+	ctx_update_t		update;
+	ctx_final_t			final;
+	size_t				oneblock_max;
+	digest_function_t	oneblock;
+	ctx_pending_t		pending;
+	ctx_final_mb_t		final_mb;
+}				hash_algo_t;
+
+/* Memory-mapped digest index (see src/index.c) */
+typedef struct	digest_index_s
+{
+	const uint8_t					*map;
+	size_t							size;
+	const struct index_header_s		*header;
+	const uint64_t					*bloom;
+	const uint8_t					*digests;
+	size_t							matches;
+}				digest_index_t;
+
+/* Growable buffer collecting the output of a request (see src/display.c) */
+typedef struct	output_buffer_s
+{
+	char	*data;
+	size_t	len;
+	size_t	capacity;
+}				output_buffer_t;
+
 /*
+	Request for one hashing command: its inputs, flags and output sink.
+	Every command line (or interactive "execute" line) gets its own request,
+	so nothing carries over from one command to the next. Results are written
+	to 'out', or appended to 'capture' when it is set (so that commands running
+	concurrently can be printed in order); 'midstate' and 'filter' hold the
+	--prefix-file state and the --index filter once loaded.
 	Commands:
 	- 0 = non valid command
 	- 1 = md5
 	- 2 = sha256
+	- 3 = whirlpool
+	Encodings of the digests: ENCODING_HEX (default), ENCODING_BINARY
+	(--binary, raw digests back to back) or ENCODING_BASE64 (--base64).
 */
 typedef struct	args_s
 {
-	int		echo;
-	int		quiet;
-	int		reverse;
-	int		command;
-	char	*strings[MAX_STRINGS];
-	int		num_strings;
-	char	*files[MAX_FILES];
-	int		num_files;
+	int				echo;
+	int				quiet;
+	int				reverse;
+	int				command;
+	int				recursive;
+	int				null_data;
+	int				disk_order;
+	int				fail_fast;
+	int				per_line;
+	int				batch;
+	int				tar;
+	int				encoding;
+	int				field;
+	char			delimiter;
+	char			*files_from;
+	char			*check_file;
+	char			*index_file;
+	char			*prefix_file;
+	char			*strings[MAX_STRINGS];
+	int				num_strings;
+	char			*files[MAX_FILES];
+	int				num_files;
+	int				out;
+	output_buffer_t	*capture;
+	hash_ctx_t		midstate;
+	digest_index_t	filter;
 }				args_t;
 
-/* Pointer to hash function */
-typedef char *(*hash_function_t)(uint8_t *, size_t);
+/* Function run by a hashing worker, takes ownership of the path */
+typedef void (*job_function_t)(char *, void *);
+
+typedef struct	job_s
+{
+	job_function_t	run;
+	char			*path;
+	void			*data;
+	uint64_t		key;
+}				job_t;
+
+/* Shared-memory session of the serve daemon (see src/shm.c) */
+typedef struct shm_session_s	shm_session_t;
+
+/* Called for each record of a stream, the record is not NUL-terminated */
+typedef void (*record_callback_t)(const char *, size_t, void *);
+
+/* File discovered by the directory walker */
+typedef struct	walk_entry_s
+{
+	char		*path;
+	uint64_t	size;
+	uint64_t	ino;
+}				walk_entry_t;
+
+/* Called for each file found, takes ownership of the entry path */
+typedef void (*walk_callback_t)(walk_entry_t *, void *);
 
 // MAIN
-void	ft_hash(void);
+int		ft_hash(args_t *args);
+void	display_digest(const args_t *args, const uint8_t *digest, char *name, int type);
 
 // INTERACTIVE
 void	ft_command_line(void);
+int		execute_prepare(args_t *args, char **tokens, int count, const char *mode);
+int		execute_runs_alone(const args_t *args);
 
 // DISPLAY
 void	print_error_and_exit(char *str);
-void	display_hash(char *hash, char *filename, int type);
-void	print_error(char *filename, char *error_msg);
+void	print_request_error(const args_t *args, char *str);
+void	display_hash(const args_t *args, char *hash, char *filename, int type);
+void	print_error(const args_t *args, char *filename, char *error_msg);
+void	display_check(const args_t *args, char *filename, const char *status);
+void	display_cracked(const char *hex, const char *word, size_t len);
+char	*display_reserve(const args_t *args, size_t len);
+void	display_commit(const args_t *args, size_t len);
+void	display_printf(const args_t *args, const char *format, ...);
+size_t	display_encode(const args_t *args, const uint8_t *digest, size_t size, char *out);
+
+// OUTPUT
+void	output_flush(void);
+char	*output_reserve(int fd, size_t len);
+void	output_commit(size_t len);
+void	output_write(int fd, const void *data, size_t len);
 
 // PARSE
-void	parse_args(int ac, char **av);
+void	args_init(args_t *args);
+int		parse_args(args_t *args, int ac, char **av);
+
+// ENGINE
+int		engine_threads(void);
+void	engine_start(int flags);
+void	engine_submit(job_function_t run, char *path, void *data);
+int		engine_try_submit(job_function_t run, char *path, void *data);
+void	engine_finish(void);
+
+// WALK
+void	walk_tree(const args_t *args, char **roots, int count, int flags, walk_callback_t on_file, void *data);
+
+// FILE LIST
+int		read_records(const args_t *args, const char *path, char delimiter, record_callback_t on_record, void *data);
+void	read_file_list(const args_t *args, const char *list, char delimiter, job_function_t run, void *data);
+
+// PER LINE
+int		hash_lines(const args_t *args, const char *path);
+
+// BATCH
+int		hash_batch(const args_t *args);
+
+// TAR
+int		hash_tar(const args_t *args, const char *path);
+
+// CHECK
+int		check_manifest(const args_t *args);
+
+// ALGORITHMS
+const hash_algo_t	*get_algo(int command);
+int		find_algo(const char *name);
+void	midstate_init(const hash_algo_t *algo, const uint8_t *prefix, size_t size, hash_ctx_t *midstate);
+void	midstate_digest(const hash_algo_t *algo, const hash_ctx_t *midstate, const uint8_t *msg, size_t size, uint8_t *digest);
+void	midstate_digest_batch(const hash_algo_t *algo, const hash_ctx_t *midstate, const uint8_t **msgs, const size_t *lens, uint8_t **digests, size_t count);
+void	digest_batch(const hash_algo_t *algo, const uint8_t **msgs, const size_t *lens, uint8_t **digests, size_t count);
+
+// DEDUP
+int		dedup_command(int ac, char **av);
+
+// STORE
+int		store_command(int ac, char **av);
+
+// CRACK
+int		crack_command(int ac, char **av);
+
+// HMAC
+int		hmac_command(int ac, char **av);
+void	hmac_init(const hash_algo_t *algo, const uint8_t *key, size_t len, hash_ctx_t *inner, hash_ctx_t *outer);
+
+// PBKDF2
+int		pbkdf2_command(int ac, char **av);
+
+// SERVE
+int		serve_command(int ac, char **av);
+shm_session_t	*shm_attach(int fd, const char **error);
+void	shm_detach(shm_session_t *session);
+
+// SCRIPT
+int		script_command(int ac, char **av);
+
+// POW
+int		pow_command(int ac, char **av);
+
+// BENCH
+int		bench_command(int ac, char **av);
+
+// INDEX
+int		index_command(int ac, char **av);
+int		index_open(const args_t *args, const char *path, digest_index_t *index);
+void	index_close(digest_index_t *index);
+int		index_contains(const digest_index_t *index, const uint8_t *digest);
+int		index_load_filter(args_t *args);
+int		index_filter_match(const args_t *args, const uint8_t *digest);
 
 // MD5
 char	*my_MD5(uint8_t *original_msg, size_t len);
+void	md5_digest(const uint8_t *original_msg, size_t len, uint8_t *digest);
 
 // SHA256
 char	*my_SHA256(uint8_t *original_msg, size_t size);
+void	sha256_digest(const uint8_t *original_msg, size_t size, uint8_t *digest);
 
 // WHIRLPOOL
 char	*my_WHIRLPOOL(uint8_t *original_msg, size_t size);
+void	whirlpool_digest(const uint8_t *original_msg, size_t size, uint8_t *digest);
 
-// TOOLS
+// ARENA
+void	*arena_scratch(size_t size);
+size_t	alloc_count(void);
+
+// ENCODE
 char	*bytes_to_hex_string(uint8_t *bytes, size_t num_bytes);
-uint8_t	*read_binary_file(const char *filename, size_t *size);
+void	hex_encode(const uint8_t *bytes, size_t num_bytes, char *out);
+size_t	base64_encode(const uint8_t *bytes, size_t num_bytes, char *out);
+
+// TOOLS
+uint8_t	*read_binary_file(const args_t *args, const char *filename, size_t *size);
+int		hash_stream_file(const args_t *args, const char *path, const hash_algo_t *algo,
+			hash_ctx_t *ctx, uint64_t *size);
 void	remove_return(char *str);
+int		hex_string_to_bytes(const char *hex, size_t num_bytes, uint8_t *bytes);
+char	*map_file(const args_t *args, const char *path, size_t *size, int *mapped);
+void	unmap_file(char *content, size_t size, int mapped);
 
 #endif
@@ -27,16 +27,9 @@
 # define whirlpool_block_size 64
 
 /**
- * Structure representing the Whirlpool hashing context.
- * This structure holds the internal state of the Whirlpool hash computation,
- * including the current hash value, a message buffer for processing,
- * and the total length of the processed data.
+ * Longest message whose padding (with its 256-bit length) still fits in a
+ * single 64-byte block.
  */
-typedef struct	whirlpool_ctx
-{
-	uint64_t		hash[8];						/* 512-bit algorithm internal hashing state */
-	unsigned char	message[whirlpool_block_size];	/* 512-bit buffer to hash */
-	uint64_t		length;							/* number of processed bytes */
-}				whirlpool_ctx;
+# define WHIRLPOOL_ONEBLOCK_MAX 31
 
 #endif
@@ -0,0 +1,69 @@
+#ifndef LIBFTSSL_H
+# define LIBFTSSL_H
+
+# include <stddef.h>
+# include <stdint.h>
+
+/**
+ * libftssl: the hash cores of ft_ssl as an embeddable C library.
+ *
+ * Build with "make lib" (libftssl.a and libftssl.so) and link with -lftssl.
+ * The library never allocates: contexts and digests live in caller memory, so
+ * every function may be called from any number of threads at once, as long
+ * as a context is not shared without locking. Its only global state is the
+ * process-wide selection of compression kernels, which ftssl_set_impl()
+ * changes: it must not be called while other threads are hashing.
+ */
+
+# ifndef FTSSL_API
+#  define FTSSL_API __attribute__((visibility("default")))
+# endif
+
+/* Largest digest, in bytes (WHIRLPOOL) */
+# define FTSSL_MAX_DIGEST_SIZE 64
+
+/* Room reserved for the state of any algorithm in an ftssl_ctx_t */
+# define FTSSL_CTX_SIZE 192
+
+typedef enum	ftssl_algo_e
+{
+	FTSSL_MD5 = 1,
+	FTSSL_SHA256 = 2,
+	FTSSL_WHIRLPOOL = 3
+}				ftssl_algo_t;
+
+/* Streaming context, to be allocated by the caller (on the stack is fine) */
+typedef struct	ftssl_ctx_s
+{
+	ftssl_algo_t	algo;
+	union
+	{
+		uint64_t		align;
+		unsigned char	bytes[FTSSL_CTX_SIZE];
+	}				state;
+}				ftssl_ctx_t;
+
+/* Algorithms */
+FTSSL_API ftssl_algo_t	ftssl_algo_by_name(const char *name);
+FTSSL_API size_t		ftssl_digest_size(ftssl_algo_t algo);
+
+/* Streaming: init, any number of updates, final */
+FTSSL_API int			ftssl_init(ftssl_ctx_t *ctx, ftssl_algo_t algo);
+FTSSL_API void			ftssl_update(ftssl_ctx_t *ctx, const void *data, size_t len);
+FTSSL_API void			ftssl_final(ftssl_ctx_t *ctx, uint8_t *digest);
+
+/* One-shot and batch (messages[i] of lens[i] bytes to digests[i]) */
+FTSSL_API int			ftssl_digest(ftssl_algo_t algo, const void *data, size_t len, uint8_t *digest);
+FTSSL_API int			ftssl_digest_batch(ftssl_algo_t algo, const uint8_t *const *messages,
+							const size_t *lens, uint8_t *const *digests, size_t count);
+
+/* Lowercase hexadecimal of 'len' bytes into 2 * len characters, no NUL */
+FTSSL_API void			ftssl_hex(const uint8_t *bytes, size_t len, char *out);
+
+/* Compression kernels, chosen from the CPU at load time and overridden with
+   ftssl_set_impl(), for the whole process: call it before any hashing
+   thread is started. */
+FTSSL_API const char	*ftssl_impl(void);
+FTSSL_API int			ftssl_set_impl(const char *name);
+
+#endif
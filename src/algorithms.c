@@ -0,0 +1,166 @@
+#include "../includes/ft_ssl.h"
+#include "../includes/ft_md5.h"
+#include "../includes/ft_sha256.h"
+#include "../includes/ft_whirlpool.h"
+
+/*
+ * Adapters from the generic hash_ctx_t to the context of each algorithm.
+ */
+static void	md5_ctx_init(hash_ctx_t *ctx) { md5_init(&ctx->md5); }
+static void	md5_ctx_update(hash_ctx_t *ctx, const uint8_t *msg, size_t size) { md5_update(&ctx->md5, msg, size); }
+static void	md5_ctx_final(hash_ctx_t *ctx, uint8_t *digest) { md5_final(&ctx->md5, digest); }
+static size_t	md5_ctx_pending(const hash_ctx_t *ctx) { return (ctx->md5.length & 63); }
+static void	md5_ctx_final_mb(const hash_ctx_t *ctx, const uint8_t **msgs, const size_t *lens, uint8_t **digests, int count) { md5_final_mb(&ctx->md5, msgs, lens, digests, count); }
+
+static void	sha256_ctx_init(hash_ctx_t *ctx) { sha256_init_blocks(&ctx->sha256); }
+static void	sha256_ctx_update(hash_ctx_t *ctx, const uint8_t *msg, size_t size) { sha256_update(&ctx->sha256, msg, size); }
+static void	sha256_ctx_final(hash_ctx_t *ctx, uint8_t *digest) { sha256_final(&ctx->sha256, digest); }
+static size_t	sha256_ctx_pending(const hash_ctx_t *ctx) { return (ctx->sha256.count & 63); }
+static void	sha256_ctx_final_mb(const hash_ctx_t *ctx, const uint8_t **msgs, const size_t *lens, uint8_t **digests, int count) { sha256_final_mb(&ctx->sha256, msgs, lens, digests, count); }
+
+static void	whirlpool_ctx_init(hash_ctx_t *ctx) { whirlpool_init(&ctx->whirlpool); }
+static void	whirlpool_ctx_update(hash_ctx_t *ctx, const uint8_t *msg, size_t size) { whirlpool_update(&ctx->whirlpool, msg, size); }
+static void	whirlpool_ctx_final(hash_ctx_t *ctx, uint8_t *digest) { whirlpool_final(&ctx->whirlpool, digest); }
+static size_t	whirlpool_ctx_pending(const hash_ctx_t *ctx) { return (ctx->whirlpool.length & 63); }
+
+/**
+ * Table of the supported hash algorithms, indexed by command number - 1.
+ */
+static const hash_algo_t	algorithms[] = {
+	{"md5", "MD5", MD5_DIGEST_SIZE, md5_digest, md5_ctx_init, md5_ctx_update, md5_ctx_final,
+		MD5_ONEBLOCK_MAX, md5_oneblock, md5_ctx_pending, md5_ctx_final_mb},
+	{"sha256", "SHA256", SHA256_DIGEST_SIZE, sha256_digest, sha256_ctx_init, sha256_ctx_update, sha256_ctx_final,
+		SHA256_ONEBLOCK_MAX, sha256_oneblock, sha256_ctx_pending, sha256_ctx_final_mb},
+	{"whirlpool", "WHIRLPOOL", WHIRLPOOL_DIGEST_SIZE, whirlpool_digest, whirlpool_ctx_init, whirlpool_ctx_update, whirlpool_ctx_final,
+		WHIRLPOOL_ONEBLOCK_MAX, whirlpool_oneblock, whirlpool_ctx_pending, NULL}
+};
+
+/**
+ * Returns the description of the algorithm selected by a command number.
+ *
+ * @param command The command number (1 = md5, 2 = sha256, 3 = whirlpool).
+ * @return Pointer to the algorithm description, or NULL for an invalid command.
+ */
+const hash_algo_t	*get_algo(int command)
+{
+	if (command < 1 || command > (int)(sizeof(algorithms) / sizeof(algorithms[0])))
+		return (NULL);
+	return (&algorithms[command - 1]);
+}
+
+/**
+ * Looks up an algorithm by name.
+ *
+ * @param name The algorithm name ("md5", "sha256" or "whirlpool").
+ * @return The matching command number, or 0 if the algorithm is unknown.
+ */
+int	find_algo(const char *name)
+{
+	for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++)
+	{
+		if (strcmp(name, algorithms[i].name) == 0)
+			return ((int)i + 1);
+	}
+	return (0);
+}
+
+/**
+ * Compresses a prefix shared by many messages once and keeps the resulting
+ * state (midstate), so that it can be reused by midstate_digest().
+ *
+ * @param algo The algorithm to use.
+ * @param prefix The shared prefix.
+ * @param size The length of the prefix in bytes.
+ * @param midstate The context receiving the state after the prefix.
+ */
+void	midstate_init(const hash_algo_t *algo, const uint8_t *prefix, size_t size, hash_ctx_t *midstate)
+{
+	algo->init(midstate);
+	algo->update(midstate, prefix, size);
+}
+
+/**
+ * Computes the digest of prefix || msg from a midstate.
+ * The midstate is cloned, so only the blocks of 'msg' (and the last partial
+ * block of the prefix) are compressed; the midstate can be reused at will.
+ *
+ * @param algo The algorithm of the midstate.
+ * @param midstate The state after the prefix, from midstate_init().
+ * @param msg The message following the prefix.
+ * @param size The length of the message in bytes.
+ * @param digest Buffer of at least algo->digest_size bytes receiving the digest.
+ */
+void	midstate_digest(const hash_algo_t *algo, const hash_ctx_t *midstate, const uint8_t *msg, size_t size, uint8_t *digest)
+{
+	hash_ctx_t	ctx = *midstate;
+
+	algo->update(&ctx, msg, size);
+	algo->final(&ctx, digest);
+}
+
+/**
+ * Computes the digests of midstate || msg for a batch of messages.
+ * Messages that fit, with the bytes pending in the midstate, in a single
+ * padded block are finished MB_LANES at a time by the multi-lane kernel of the
+ * algorithm, when it has one; the others are finished one by one.
+ *
+ * @param algo The algorithm of the midstate.
+ * @param midstate The state after the shared prefix, left untouched.
+ * @param msgs The messages.
+ * @param lens The lengths of the messages.
+ * @param digests Buffers of at least algo->digest_size bytes receiving the digests.
+ * @param count The number of messages.
+ */
+void	midstate_digest_batch(const hash_algo_t *algo, const hash_ctx_t *midstate, const uint8_t **msgs, const size_t *lens, uint8_t **digests, size_t count)
+{
+	const uint8_t	*lane_msgs[MB_LANES];
+	size_t			lane_lens[MB_LANES];
+	uint8_t			*lane_digests[MB_LANES];
+	size_t			pending = algo->pending(midstate);
+	int				lanes = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!algo->final_mb || pending + lens[i] > algo->oneblock_max)
+		{
+			midstate_digest(algo, midstate, msgs[i], lens[i], digests[i]);
+			continue;
+		}
+		lane_msgs[lanes] = msgs[i];
+		lane_lens[lanes] = lens[i];
+		lane_digests[lanes] = digests[i];
+		if (++lanes == MB_LANES)
+		{
+			algo->final_mb(midstate, lane_msgs, lane_lens, lane_digests, lanes);
+			lanes = 0;
+		}
+	}
+	if (lanes)
+		algo->final_mb(midstate, lane_msgs, lane_lens, lane_digests, lanes);
+}
+
+/**
+ * Computes the digests of a batch of messages.
+ * Short messages are grouped MB_LANES at a time into the multi-lane kernel of
+ * the algorithm, when it has one; the others go through the regular digest
+ * function, which has its own single-block fast path.
+ *
+ * @param algo The algorithm to use.
+ * @param msgs The messages.
+ * @param lens The lengths of the messages.
+ * @param digests Buffers of at least algo->digest_size bytes receiving the digests.
+ * @param count The number of messages.
+ */
+void	digest_batch(const hash_algo_t *algo, const uint8_t **msgs, const size_t *lens, uint8_t **digests, size_t count)
+{
+	hash_ctx_t	ctx;
+
+	if (!algo->final_mb)
+	{
+		for (size_t i = 0; i < count; i++)
+			algo->digest(msgs[i], lens[i], digests[i]);
+		return;
+	}
+	algo->init(&ctx);
+	midstate_digest_batch(algo, &ctx, msgs, lens, digests, count);
+}
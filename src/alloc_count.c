@@ -0,0 +1,50 @@
+#include "../includes/ft_ssl.h"
+
+/**
+ * Number of heap allocations made by the process, counted by wrapping the
+ * allocator so that benchmarks can check that a path does not allocate.
+ * The wrappers rely on the __libc_* entry points, so the counter is only
+ * available with glibc, and only in the ft_ssl_bench binary (make bench),
+ * built with FT_SSL_ALLOC_COUNT: ft_ssl keeps the allocator of the libc.
+ */
+#if defined(__GLIBC__) && defined(FT_SSL_ALLOC_COUNT)
+
+static size_t	allocations;
+
+void	*__libc_malloc(size_t size);
+void	*__libc_calloc(size_t count, size_t size);
+void	*__libc_realloc(void *ptr, size_t size);
+
+void	*malloc(size_t size)
+{
+	__atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+	return (__libc_malloc(size));
+}
+
+void	*calloc(size_t count, size_t size)
+{
+	__atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+	return (__libc_calloc(count, size));
+}
+
+void	*realloc(void *ptr, size_t size)
+{
+	__atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+	return (__libc_realloc(ptr, size));
+}
+
+#endif
+
+/**
+ * Returns the number of calls to malloc(), calloc() and realloc() so far.
+ *
+ * @return The count, or (size_t)-1 when the allocator cannot be counted.
+ */
+size_t	alloc_count(void)
+{
+#if defined(__GLIBC__) && defined(FT_SSL_ALLOC_COUNT)
+	return (__atomic_load_n(&allocations, __ATOMIC_RELAXED));
+#else
+	return ((size_t)-1);
+#endif
+}
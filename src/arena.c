@@ -0,0 +1,62 @@
+#include "../includes/ft_ssl.h"
+
+/**
+ * Scratch memory of a thread, reused by every message it hashes.
+ * It only grows, and is released when the thread exits, so that hashing
+ * does not allocate once each thread has seen its largest request.
+ */
+typedef struct	arena_s
+{
+	uint8_t	*data;
+	size_t	capacity;
+}				arena_t;
+
+static pthread_key_t	arena_key;
+static pthread_once_t	arena_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Releases the arena of an exiting thread.
+ *
+ * @param data The arena of the thread.
+ */
+static void	arena_release(void *data)
+{
+	arena_t	*arena = data;
+
+	free(arena->data);
+	free(arena);
+}
+
+static void	arena_key_create(void)
+{
+	pthread_key_create(&arena_key, arena_release);
+}
+
+/**
+ * Returns the scratch buffer of the calling thread, of at least 'size' bytes.
+ * The buffer stays valid until the next call on the same thread, so a caller
+ * must be done with it before calling anything that may use it too.
+ *
+ * @param size The number of bytes needed.
+ * @return The buffer.
+ */
+void	*arena_scratch(size_t size)
+{
+	arena_t	*arena;
+
+	pthread_once(&arena_once, arena_key_create);
+	if (!(arena = pthread_getspecific(arena_key)))
+	{
+		if (!(arena = calloc(1, sizeof(arena_t))))
+			print_error_and_exit("malloc() failed");
+		pthread_setspecific(arena_key, arena);
+	}
+	if (arena->capacity < size)
+	{
+		free(arena->data);
+		if (!(arena->data = malloc(size)))
+			print_error_and_exit("malloc() failed");
+		arena->capacity = size;
+	}
+	return (arena->data);
+}
@@ -0,0 +1,432 @@
+#include "../includes/ft_ssl.h"
+#include <sys/uio.h>
+
+/**
+ * Number of bytes read into a chunk at a time. A chunk grows beyond this
+ * only to hold a record that does not fit.
+ */
+#define BATCH_CHUNK (1 << 20)
+
+/**
+ * Number of chunks in flight between the reader, the workers and the writer.
+ */
+#define BATCH_SLOTS 8
+
+/**
+ * Number of records hashed by a single worker job.
+ */
+#define BATCH_SLICE 256
+
+/**
+ * Size of the length prefix of a record: a 32-bit big-endian integer.
+ */
+#define BATCH_HEADER 4
+
+/* Life cycle of a chunk */
+#define BATCH_FREE 0
+#define BATCH_HASHING 1
+#define BATCH_DONE 2
+
+/**
+ * Records of a chunk hashed by one worker job.
+ */
+typedef struct	batch_slice_s
+{
+	struct batch_chunk_s	*chunk;
+	size_t					start;
+	size_t					count;
+}				batch_slice_t;
+
+/**
+ * Records read at once, with their digests.
+ * 'msgs' point into 'buffer'; the digests are stored back to back, in the
+ * order of the records, so that a chunk is written with a single iovec.
+ * The arrays only grow, and are reused from one chunk to the next.
+ */
+typedef struct	batch_chunk_s
+{
+	struct batch_s	*batch;
+	int				state;
+	size_t			pending;
+	char			*buffer;
+	size_t			capacity;
+	const uint8_t	**msgs;
+	size_t			*lens;
+	size_t			count;
+	size_t			records_capacity;
+	uint8_t			*digests;
+	size_t			digests_capacity;
+	batch_slice_t	*slices;
+	size_t			slices_capacity;
+}				batch_chunk_t;
+
+/**
+ * Pipeline shared by the reader (main thread), the hashing workers and the
+ * writer thread. Chunks are filled and written in sequence order.
+ */
+typedef struct	batch_s
+{
+	const args_t		*args;
+	const hash_algo_t	*algo;
+	const hash_ctx_t	*midstate;
+	pthread_mutex_t		lock;
+	pthread_cond_t		changed;
+	batch_chunk_t		chunks[BATCH_SLOTS];
+	size_t				read_seq;
+	size_t				write_seq;
+	int					eof;
+}				batch_t;
+
+/**
+ * Worker job hashing a slice of a chunk.
+ * The last slice to finish marks the chunk as ready for the writer.
+ *
+ * @param path Unused.
+ * @param data Pointer to the batch_slice_t to hash.
+ */
+static void	hash_slice(char *path, void *data)
+{
+	batch_slice_t	*slice = data;
+	batch_chunk_t	*chunk = slice->chunk;
+	batch_t			*batch = chunk->batch;
+	uint8_t			*outputs[BATCH_SLICE];
+
+	(void)path;
+	for (size_t i = 0; i < slice->count; i++)
+		outputs[i] = chunk->digests + (slice->start + i) * batch->algo->digest_size;
+	if (batch->midstate)
+		midstate_digest_batch(batch->algo, batch->midstate, chunk->msgs + slice->start,
+			chunk->lens + slice->start, outputs, slice->count);
+	else
+		digest_batch(batch->algo, chunk->msgs + slice->start, chunk->lens + slice->start,
+			outputs, slice->count);
+	pthread_mutex_lock(&batch->lock);
+	if (--chunk->pending == 0)
+	{
+		chunk->state = BATCH_DONE;
+		pthread_cond_broadcast(&batch->changed);
+	}
+	pthread_mutex_unlock(&batch->lock);
+}
+
+/**
+ * Writes a whole iovec array, resuming after partial writes.
+ *
+ * @param fd The descriptor to write to.
+ * @param iov The buffers to write, modified by this function.
+ * @param count The number of buffers.
+ * @return 0 on success, -1 on error.
+ */
+static int	write_all(int fd, struct iovec *iov, int count)
+{
+	while (count > 0)
+	{
+		ssize_t	written = writev(fd, iov, count);
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+		while (count > 0 && (size_t)written >= iov->iov_len)
+		{
+			written -= iov->iov_len;
+			iov++;
+			count--;
+		}
+		if (count > 0)
+		{
+			iov->iov_base = (char *)iov->iov_base + written;
+			iov->iov_len -= written;
+		}
+	}
+	return (0);
+}
+
+/**
+ * Main loop of the writer thread.
+ * Waits for the next chunk in sequence to be hashed, then writes it together
+ * with every following chunk that is already done, in a single writev().
+ *
+ * @param data Pointer to the batch_t pipeline.
+ * @return NULL, or a non-NULL pointer if the output could not be written.
+ */
+static void	*batch_writer(void *data)
+{
+	batch_t			*batch = data;
+	struct iovec	iov[BATCH_SLOTS];
+	int				failed = 0;
+
+	while (1)
+	{
+		int	count = 0;
+
+		pthread_mutex_lock(&batch->lock);
+		while (batch->chunks[batch->write_seq % BATCH_SLOTS].state != BATCH_DONE
+			&& !(batch->eof && batch->write_seq == batch->read_seq))
+			pthread_cond_wait(&batch->changed, &batch->lock);
+		while (count < BATCH_SLOTS
+			&& batch->chunks[(batch->write_seq + count) % BATCH_SLOTS].state == BATCH_DONE)
+		{
+			batch_chunk_t	*chunk = &batch->chunks[(batch->write_seq + count) % BATCH_SLOTS];
+
+			iov[count].iov_base = chunk->digests;
+			iov[count].iov_len = chunk->count * batch->algo->digest_size;
+			count++;
+		}
+		pthread_mutex_unlock(&batch->lock);
+		if (count == 0)
+			break;
+		if (!failed && write_all(batch->args->out, iov, count) == -1)
+		{
+			perror("ft_ssl: writev() failed");
+			failed = 1;
+		}
+		pthread_mutex_lock(&batch->lock);
+		for (int i = 0; i < count; i++)
+			batch->chunks[(batch->write_seq + i) % BATCH_SLOTS].state = BATCH_FREE;
+		batch->write_seq += count;
+		pthread_cond_broadcast(&batch->changed);
+		pthread_mutex_unlock(&batch->lock);
+	}
+	return (failed ? (void *)1 : NULL);
+}
+
+/**
+ * Waits for the next chunk in sequence to be written, so that it can be
+ * refilled by the reader.
+ *
+ * @param batch The pipeline.
+ * @return The chunk.
+ */
+static batch_chunk_t	*acquire_chunk(batch_t *batch)
+{
+	batch_chunk_t	*chunk = &batch->chunks[batch->read_seq % BATCH_SLOTS];
+
+	pthread_mutex_lock(&batch->lock);
+	while (chunk->state != BATCH_FREE)
+		pthread_cond_wait(&batch->changed, &batch->lock);
+	pthread_mutex_unlock(&batch->lock);
+	chunk->count = 0;
+	return (chunk);
+}
+
+/**
+ * Grows an array to at least 'size' elements, exiting on allocation failure.
+ *
+ * @param ptr Pointer to the array.
+ * @param capacity Pointer to the capacity of the array, in elements.
+ * @param size The capacity needed, in elements.
+ * @param elem The size of an element.
+ */
+static void	reserve(void **ptr, size_t *capacity, size_t size, size_t elem)
+{
+	size_t	new_capacity = *capacity ? *capacity : 1024;
+	void	*grown;
+
+	if (size <= *capacity)
+		return;
+	while (new_capacity < size)
+		new_capacity *= 2;
+	if (!(grown = realloc(*ptr, new_capacity * elem)))
+		print_error_and_exit("realloc() failed");
+	*ptr = grown;
+	*capacity = new_capacity;
+}
+
+/**
+ * Indexes the complete records at the start of a chunk buffer.
+ *
+ * @param chunk The chunk.
+ * @param size The number of bytes in the buffer.
+ * @param needed Receives the size of the incomplete record left at the end
+ *   (at least its header), so that the next chunk can be made large enough.
+ * @return The number of bytes used by the complete records.
+ */
+static size_t	index_records(batch_chunk_t *chunk, size_t size, size_t *needed)
+{
+	const uint8_t	*buffer = (const uint8_t *)chunk->buffer;
+	size_t			pos = 0;
+
+	*needed = BATCH_HEADER;
+	while (size - pos >= BATCH_HEADER)
+	{
+		size_t	len = (size_t)buffer[pos] << 24 | buffer[pos + 1] << 16
+			| buffer[pos + 2] << 8 | buffer[pos + 3];
+
+		if (size - pos - BATCH_HEADER < len)
+		{
+			*needed = BATCH_HEADER + len;
+			break;
+		}
+		if (chunk->count == chunk->records_capacity)
+		{
+			size_t	capacity = chunk->records_capacity;
+
+			reserve((void **)&chunk->msgs, &capacity, chunk->count + 1, sizeof(*chunk->msgs));
+			reserve((void **)&chunk->lens, &chunk->records_capacity, chunk->count + 1, sizeof(*chunk->lens));
+		}
+		chunk->msgs[chunk->count] = buffer + pos + BATCH_HEADER;
+		chunk->lens[chunk->count++] = len;
+		pos += BATCH_HEADER + len;
+	}
+	return (pos);
+}
+
+/**
+ * Hands the records of a chunk to the workers, BATCH_SLICE at a time.
+ * The engine queue may block, so the pipeline lock is only held while the
+ * chunk is published.
+ *
+ * @param batch The pipeline.
+ * @param chunk The chunk, with at least one record.
+ */
+static void	submit_chunk(batch_t *batch, batch_chunk_t *chunk)
+{
+	size_t	slices = (chunk->count + BATCH_SLICE - 1) / BATCH_SLICE;
+
+	reserve((void **)&chunk->digests, &chunk->digests_capacity, chunk->count, batch->algo->digest_size);
+	reserve((void **)&chunk->slices, &chunk->slices_capacity, slices, sizeof(batch_slice_t));
+	pthread_mutex_lock(&batch->lock);
+	chunk->state = BATCH_HASHING;
+	chunk->pending = slices;
+	batch->read_seq++;
+	pthread_mutex_unlock(&batch->lock);
+	for (size_t i = 0; i < slices; i++)
+	{
+		batch_slice_t	*slice = &chunk->slices[i];
+
+		slice->chunk = chunk;
+		slice->start = i * BATCH_SLICE;
+		slice->count = (i + 1 < slices) ? BATCH_SLICE : chunk->count - slice->start;
+		engine_submit(hash_slice, NULL, slice);
+	}
+}
+
+/**
+ * Reads length-prefixed records until at least one is complete.
+ * The incomplete record left at the end of the previous chunk is carried
+ * over at the start of this one.
+ *
+ * @param batch The pipeline.
+ * @param chunk The chunk to fill.
+ * @param carry Pointer to the carried bytes, replaced by the new leftover.
+ * @param carry_len Pointer to the number of carried bytes.
+ * @return 1 if records were indexed, 0 at the end of the input, -1 if stdin
+ * could not be read (the records indexed before the error are kept).
+ */
+static int	fill_chunk(batch_t *batch, batch_chunk_t *chunk, char **carry, size_t *carry_len)
+{
+	size_t	size = *carry_len;
+	size_t	needed = size;
+	size_t	used = 0;
+	ssize_t	bytes_read;
+
+	if (needed < BATCH_CHUNK)
+		needed = BATCH_CHUNK;
+	reserve((void **)&chunk->buffer, &chunk->capacity, needed, 1);
+	if (size)
+		memcpy(chunk->buffer, *carry, size);
+	while (1)
+	{
+		bytes_read = read(STDIN_FILENO, chunk->buffer + size, chunk->capacity - size);
+		if (bytes_read == -1 && errno == EINTR)
+			continue;
+		if (bytes_read <= 0)
+			break;
+		size += bytes_read;
+		used = index_records(chunk, size, &needed);
+		if (chunk->count)
+			break;
+		reserve((void **)&chunk->buffer, &chunk->capacity, needed, 1);
+	}
+	if (bytes_read == -1)
+		print_error(batch->args, "stdin", strerror(errno));
+	*carry_len = size - used;
+	if (*carry_len)
+	{
+		char	*leftover = malloc(*carry_len);
+		if (!leftover)
+			print_error_and_exit("malloc() failed");
+		memcpy(leftover, chunk->buffer + used, *carry_len);
+		free(*carry);
+		*carry = leftover;
+	}
+	if (bytes_read == -1)
+		return (-1);
+	return (chunk->count != 0);
+}
+
+/**
+ * Hashes length-prefixed binary records read from stdin and writes their raw
+ * digests to stdout, in the same order, without any separator.
+ * Each record is a 32-bit big-endian length followed by that many bytes.
+ * The reader, the hashing workers and the writer run as a pipeline over
+ * BATCH_SLOTS chunks; records are hashed several at a time in the multi-lane
+ * kernels and ready chunks are written together with writev(). A chunk is
+ * published as soon as one of its records is complete, so a co-process
+ * waiting for a digest is never left stuck.
+ *
+ * @param args The request.
+ * @return 0 on success, 1 on a read, write or truncated record error.
+ */
+int	hash_batch(const args_t *args)
+{
+	batch_t		*batch = calloc(1, sizeof(batch_t));
+	pthread_t	writer;
+	void		*write_failed = NULL;
+	char		*carry = NULL;
+	size_t		carry_len = 0;
+	int			ret = 0;
+
+	if (!batch)
+		print_error_and_exit("malloc() failed");
+	pthread_mutex_init(&batch->lock, NULL);
+	pthread_cond_init(&batch->changed, NULL);
+	batch->args = args;
+	batch->algo = get_algo(args->command);
+	batch->midstate = args->prefix_file ? &args->midstate : NULL;
+	for (int i = 0; i < BATCH_SLOTS; i++)
+		batch->chunks[i].batch = batch;
+	engine_start(0);
+	if (pthread_create(&writer, NULL, batch_writer, batch) != 0)
+		print_error_and_exit("pthread_create() failed");
+	while (1)
+	{
+		batch_chunk_t	*chunk = acquire_chunk(batch);
+		int				status = fill_chunk(batch, chunk, &carry, &carry_len);
+
+		if (status != 0 && chunk->count)
+			submit_chunk(batch, chunk);
+		if (status != 1)
+		{
+			ret = (status == -1);
+			break;
+		}
+	}
+	engine_finish();
+	pthread_mutex_lock(&batch->lock);
+	batch->eof = 1;
+	pthread_cond_broadcast(&batch->changed);
+	pthread_mutex_unlock(&batch->lock);
+	pthread_join(writer, &write_failed);
+	if (carry_len)
+	{
+		fprintf(stderr, "ft_ssl: Error: truncated record at the end of the input (%zu bytes).\n", carry_len);
+		ret = 1;
+	}
+	free(carry);
+	for (int i = 0; i < BATCH_SLOTS; i++)
+	{
+		free(batch->chunks[i].buffer);
+		free(batch->chunks[i].msgs);
+		free(batch->chunks[i].lens);
+		free(batch->chunks[i].digests);
+		free(batch->chunks[i].slices);
+	}
+	pthread_mutex_destroy(&batch->lock);
+	pthread_cond_destroy(&batch->changed);
+	free(batch);
+	return (ret || write_failed);
+}
@@ -0,0 +1,154 @@
+#include "../includes/ft_ssl.h"
+#include <time.h>
+
+/**
+ * Number of messages hashed per digest_batch() call by the benchmark.
+ */
+#define BENCH_BATCH 64
+
+/**
+ * Returns the current time of the monotonic clock in nanoseconds.
+ */
+static double	now_ns(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+/**
+ * Measures the streaming interface (init, update, final) on every message.
+ *
+ * @return The average time per message in nanoseconds.
+ */
+static double	bench_streaming(const hash_algo_t *algo, uint8_t **msgs, size_t len, size_t count)
+{
+	hash_ctx_t	ctx;
+	uint8_t		digest[MAX_DIGEST_SIZE];
+	double		start = now_ns();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		algo->init(&ctx);
+		algo->update(&ctx, msgs[i % BENCH_BATCH], len);
+		algo->final(&ctx, digest);
+	}
+	return ((now_ns() - start) / count);
+}
+
+/**
+ * Measures the one-shot digest function, which takes the single-block fast
+ * path for short messages.
+ *
+ * @return The average time per message in nanoseconds.
+ */
+static double	bench_digest(const hash_algo_t *algo, uint8_t **msgs, size_t len, size_t count)
+{
+	uint8_t	digest[MAX_DIGEST_SIZE];
+	double	start = now_ns();
+
+	for (size_t i = 0; i < count; i++)
+		algo->digest(msgs[i % BENCH_BATCH], len, digest);
+	return ((now_ns() - start) / count);
+}
+
+/**
+ * Measures digest_batch(), which feeds short messages to the multi-lane kernels.
+ *
+ * @return The average time per message in nanoseconds.
+ */
+static double	bench_batch(const hash_algo_t *algo, uint8_t **msgs, size_t len, size_t count)
+{
+	uint8_t	digests[BENCH_BATCH][MAX_DIGEST_SIZE];
+	uint8_t	*outputs[BENCH_BATCH];
+	size_t	lens[BENCH_BATCH];
+	size_t	rounds = (count + BENCH_BATCH - 1) / BENCH_BATCH;
+	double	start;
+
+	for (int i = 0; i < BENCH_BATCH; i++)
+	{
+		outputs[i] = digests[i];
+		lens[i] = len;
+	}
+	start = now_ns();
+	for (size_t i = 0; i < rounds; i++)
+		digest_batch(algo, (const uint8_t **)msgs, lens, outputs, BENCH_BATCH);
+	return ((now_ns() - start) / (rounds * BENCH_BATCH));
+}
+
+/**
+ * Runs the three measurements for one algorithm and prints a summary line,
+ * with the number of heap allocations they made (expected to be 0).
+ *
+ * @param algo The algorithm to measure.
+ * @param len The length of the messages.
+ * @param count The number of messages hashed by each measurement.
+ */
+static void	bench_algo(const hash_algo_t *algo, size_t len, size_t count)
+{
+	uint8_t	*msgs[BENCH_BATCH];
+	uint8_t	*buffer = malloc(len * BENCH_BATCH + 1);
+
+	if (!buffer)
+		print_error_and_exit("malloc() failed");
+	for (size_t i = 0; i < len * BENCH_BATCH; i++)
+		buffer[i] = (uint8_t)(i * 131 + 7);
+	for (int i = 0; i < BENCH_BATCH; i++)
+		msgs[i] = buffer + i * len;
+	size_t	allocs = alloc_count();
+	double	streaming = bench_streaming(algo, msgs, len, count);
+	double	digest = bench_digest(algo, msgs, len, count);
+	double	batch = bench_batch(algo, msgs, len, count);
+
+	allocs = alloc_count() - allocs;
+	printf("%-10s %6zu bytes  streaming %9.1f ns  digest %9.1f ns  batch %9.1f ns",
+		algo->name, len, streaming, digest, batch);
+	if (alloc_count() == (size_t)-1)
+		printf("  allocs n/a\n");
+	else
+		printf("  allocs %zu\n", allocs);
+	fflush(stdout);
+	free(buffer);
+}
+
+/**
+ * Measures the time needed to hash short messages through each interface,
+ * after naming the compression kernels selected for this CPU.
+ * Usage: ft_ssl bench [-a md5|sha256|whirlpool] [-l length] [-n count]
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "bench".
+ * @return Always 0.
+ */
+int	bench_command(int ac, char **av)
+{
+	int		command = 0;
+	size_t	len = 32;
+	size_t	count = 1000000;
+
+	for (int i = 2; i < ac; i++)
+	{
+		if (strcmp(av[i], "-a") == 0 && i + 1 < ac)
+		{
+			if (!(command = find_algo(av[++i])))
+			{
+				fprintf(stderr, "ft_ssl: Error: '%s' is an invalid algorithm.\n", av[i]);
+				exit(1);
+			}
+		}
+		else if (strcmp(av[i], "-l") == 0 && i + 1 < ac)
+			len = strtoul(av[++i], NULL, 10);
+		else if (strcmp(av[i], "-n") == 0 && i + 1 < ac && atol(av[i + 1]) > 0)
+			count = strtoul(av[++i], NULL, 10);
+		else
+			print_error_and_exit("usage: ft_ssl bench [-a md5|sha256|whirlpool] [-l length] [-n count]");
+	}
+	printf("implementation: %s (multi-lane kernels: %s, whirlpool: scalar)\n", hash_impl->name, hash_impl->lanes);
+	for (int algo = 1; get_algo(algo); algo++)
+	{
+		if (!command || algo == command)
+			bench_algo(get_algo(algo), len, count);
+	}
+	return (0);
+}
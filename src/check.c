@@ -0,0 +1,233 @@
+#include "../includes/ft_ssl.h"
+
+/**
+ * Results shared by the verification workers.
+ */
+typedef struct	check_state_s
+{
+	const args_t		*args;
+	const hash_algo_t	*algo;
+	size_t				failed;
+	size_t				unreadable;
+	size_t				bad_lines;
+	size_t				checked;
+	int					stop;
+}				check_state_t;
+
+/**
+ * Manifest entry queued for verification.
+ */
+typedef struct	check_entry_s
+{
+	check_state_t	*state;
+	uint8_t			expected[MAX_DIGEST_SIZE];
+}				check_entry_t;
+
+/**
+ * Records a failure and, in --fail-fast mode, tells everyone to stop.
+ *
+ * @param state The verification state.
+ * @param counter The counter to increment.
+ */
+static void	check_failure(check_state_t *state, size_t *counter)
+{
+	__atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+	if (state->args->fail_fast)
+		__atomic_store_n(&state->stop, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Verifies one manifest entry on a hashing worker.
+ * The file digest is compared to the expected raw digest carried by the job.
+ *
+ * @param path The path of the file to verify.
+ * @param data The check_entry_t of the file, released by this function.
+ */
+static void	check_job(char *path, void *data)
+{
+	check_entry_t	*entry = data;
+	check_state_t	*state = entry->state;
+	uint8_t			digest[MAX_DIGEST_SIZE];
+	hash_ctx_t		ctx;
+
+	if (!__atomic_load_n(&state->stop, __ATOMIC_RELAXED))
+	{
+		state->algo->init(&ctx);
+		if (hash_stream_file(state->args, path, state->algo, &ctx, NULL) != 0)
+		{
+			display_check(state->args, path, "FAILED open or read");
+			check_failure(state, &state->unreadable);
+		}
+		else
+		{
+			state->algo->final(&ctx, digest);
+			if (memcmp(digest, entry->expected, state->algo->digest_size) == 0)
+			{
+				if (!state->args->quiet)
+					display_check(state->args, path, "OK");
+			}
+			else
+			{
+				display_check(state->args, path, "FAILED");
+				check_failure(state, &state->failed);
+			}
+		}
+	}
+	free(entry);
+	free(path);
+}
+
+/**
+ * Copies the path of a manifest entry, undoing the escaping used by GNU tools
+ * for names holding a newline or a backslash.
+ *
+ * @param src The start of the path in the manifest.
+ * @param len The length of the path.
+ * @param escaped Whether the line was escaped (started with a backslash).
+ * @return A newly allocated path, or NULL on allocation failure.
+ */
+static char	*copy_path(const char *src, size_t len, int escaped)
+{
+	char	*path = malloc(len + 1);
+	size_t	j = 0;
+
+	if (!path)
+		return (NULL);
+	for (size_t i = 0; i < len; i++)
+	{
+		if (escaped && src[i] == '\\' && i + 1 < len)
+		{
+			i++;
+			path[j++] = (src[i] == 'n') ? '\n' : src[i];
+		}
+		else
+			path[j++] = src[i];
+	}
+	path[j] = '\0';
+	return (path);
+}
+
+/**
+ * Parses one manifest line and queues its verification.
+ * Accepts the GNU format ("<hex>  <path>", "<hex> *<path>"), the reversed
+ * ft_ssl format ("<hex> <path>") and the tagged format ("SHA256 (<path>) = <hex>").
+ *
+ * @param state The verification state.
+ * @param line The start of the line.
+ * @param len The length of the line, without its newline.
+ * @return 1 if the line was queued or ignored, 0 if it is improperly formatted.
+ */
+static int	check_line(check_state_t *state, const char *line, size_t len)
+{
+	size_t			hex_len = state->algo->digest_size * 2;
+	size_t			label_len = strlen(state->algo->label);
+	const char		*hex;
+	const char		*path;
+	size_t			path_len;
+	int				escaped = 0;
+
+	if (len && line[len - 1] == '\r')
+		len--;
+	if (len == 0 || line[0] == '#')
+		return (1);
+	if (line[0] == '\\')
+	{
+		escaped = 1;
+		line++;
+		len--;
+	}
+	if (len > label_len + 2 && memcmp(line, state->algo->label, label_len) == 0
+		&& line[label_len] == ' ' && line[label_len + 1] == '(')
+	{
+		if (len < label_len + 2 + 4 + hex_len)
+			return (0);
+		hex = line + len - hex_len;
+		if (memcmp(hex - 4, ") = ", 4) != 0)
+			return (0);
+		path = line + label_len + 2;
+		path_len = (hex - 4) - path;
+	}
+	else
+	{
+		if (len < hex_len + 2 || line[hex_len] != ' ')
+			return (0);
+		hex = line;
+		path = line + hex_len + 1;
+		if (*path == ' ' || *path == '*')
+			path++;
+		path_len = (line + len) - path;
+	}
+
+	check_entry_t	*entry = malloc(sizeof(check_entry_t));
+	if (path_len == 0 || !entry || !hex_string_to_bytes(hex, state->algo->digest_size, entry->expected))
+	{
+		free(entry);
+		return (0);
+	}
+	char	*file = copy_path(path, path_len, escaped);
+	if (!file)
+	{
+		free(entry);
+		return (0);
+	}
+	entry->state = state;
+	state->checked++;
+	engine_submit(check_job, file, entry);
+	return (1);
+}
+
+/**
+ * Verifies the checksums listed in a manifest (-c).
+ * Lines are split with memchr() and each entry is verified on the hashing
+ * workers by comparing raw digests. With --fail-fast, no new entry is started
+ * once a mismatch or an unreadable file has been seen.
+ *
+ * @param args The request, whose check_file is the path of the manifest or "-" for stdin.
+ * @return 0 if every listed file matched, 1 otherwise.
+ */
+int	check_manifest(const args_t *args)
+{
+	const char		*manifest = args->check_file;
+	check_state_t	state;
+	size_t			size = 0;
+	int				mapped;
+	char			*content = map_file(args, manifest, &size, &mapped);
+
+	if (!content)
+		return (1);
+	ft_bzero(&state, sizeof(state));
+	state.args = args;
+	state.algo = get_algo(args->command);
+
+	engine_start(args->disk_order ? ENGINE_DISK_ORDER : 0);
+	const char	*pos = content;
+	const char	*end = content + size;
+	while (pos < end && !__atomic_load_n(&state.stop, __ATOMIC_RELAXED))
+	{
+		const char	*next = memchr(pos, '\n', end - pos);
+		if (!next)
+			next = end;
+		if (!check_line(&state, pos, next - pos))
+			state.bad_lines++;
+		pos = next + 1;
+	}
+	engine_finish();
+
+	unmap_file(content, size, mapped);
+
+	if (state.bad_lines)
+		fprintf(stderr, "ft_ssl: WARNING: %zu line%s improperly formatted\n",
+			state.bad_lines, state.bad_lines > 1 ? "s are" : " is");
+	if (state.unreadable)
+		fprintf(stderr, "ft_ssl: WARNING: %zu listed file%s could not be read\n",
+			state.unreadable, state.unreadable > 1 ? "s" : "");
+	if (state.failed)
+		fprintf(stderr, "ft_ssl: WARNING: %zu computed checksum%s did NOT match\n",
+			state.failed, state.failed > 1 ? "s" : "");
+	if (!state.checked)
+	{
+		fprintf(stderr, "ft_ssl: %s: no properly formatted checksum lines found\n", manifest);
+		return (1);
+	}
+	return (state.failed || state.unreadable);
+}
@@ -0,0 +1,438 @@
+#include "../includes/ft_ssl.h"
+#include <time.h>
+
+/**
+ * Longest word hashed with the single-block fast path: the word, the 0x80
+ * padding byte and the 64-bit length must fit in one 64-byte block.
+ */
+#define CRACK_FAST_LEN 55
+
+/**
+ * Settings and results of a dictionary attack, shared by the workers.
+ * The target digests are indexed by an open-addressing hash set keyed by
+ * their first 8 bytes; a slot holds the index of a target plus one, 0 being
+ * an empty slot.
+ */
+typedef struct	crack_s
+{
+	const hash_algo_t	*algo;
+	compress_mb_t		compress;
+	int					state_words;
+	int					big_endian;
+	uint32_t			iv[8];
+	uint8_t				*targets;
+	uint8_t				*found;
+	size_t				count;
+	size_t				capacity;
+	uint32_t			*table;
+	size_t				mask;
+	size_t				remaining;
+	const char			*words;
+	size_t				words_size;
+}				crack_t;
+
+/**
+ * Candidates waiting to be hashed together by the multi-lane kernel.
+ * Each lane keeps its padded block between two batches: only the bytes left
+ * by a longer previous word have to be cleared.
+ */
+typedef struct	crack_lanes_s
+{
+	uint8_t		blocks[MB_LANES][64];
+	size_t		lengths[MB_LANES];
+	const char	*words[MB_LANES];
+	int			count;
+}				crack_lanes_t;
+
+/**
+ * Slice of the wordlist handled by one worker.
+ */
+typedef struct	crack_worker_s
+{
+	pthread_t	thread;
+	size_t		start;
+	size_t		end;
+	uint64_t	tried;
+}				crack_worker_t;
+
+static crack_t	crack;
+
+/**
+ * Returns the hash set slot where a digest is stored or would be stored.
+ *
+ * @param digest The raw digest.
+ * @return The slot index.
+ */
+static size_t	target_slot(const uint8_t *digest)
+{
+	uint64_t	key;
+	size_t		slot;
+
+	memcpy(&key, digest, sizeof(key));
+	slot = key & crack.mask;
+	while (crack.table[slot]
+		&& memcmp(crack.targets + (crack.table[slot] - 1) * crack.algo->digest_size,
+			digest, crack.algo->digest_size) != 0)
+		slot = (slot + 1) & crack.mask;
+	return (slot);
+}
+
+/**
+ * Record callback collecting one target digest per line.
+ * The digest must start the line and may be followed by blanks or other fields.
+ *
+ * @param line The line, not NUL-terminated.
+ * @param len The length of the line.
+ * @param data Unused.
+ */
+static void	collect_target(const char *line, size_t len, void *data)
+{
+	size_t	size = crack.algo->digest_size;
+
+	(void)data;
+	if (len < size * 2 || (len > size * 2 && !ft_strchr(" \t\r*:", line[size * 2])))
+		return;
+	if (crack.count == crack.capacity)
+	{
+		size_t	capacity = crack.capacity ? crack.capacity * 2 : 64;
+		uint8_t	*targets = realloc(crack.targets, capacity * size);
+		if (!targets)
+			print_error_and_exit("realloc() failed");
+		crack.targets = targets;
+		crack.capacity = capacity;
+	}
+	if (hex_string_to_bytes(line, size, crack.targets + crack.count * size))
+		crack.count++;
+}
+
+/**
+ * Builds the hash set of the collected targets, dropping duplicates.
+ */
+static void	build_target_set(void)
+{
+	size_t	size = crack.algo->digest_size;
+	size_t	slots = 16;
+	size_t	unique = 0;
+
+	while (slots < crack.count * 2)
+		slots *= 2;
+	crack.table = calloc(slots, sizeof(uint32_t));
+	crack.found = calloc(crack.count ? crack.count : 1, 1);
+	if (!crack.table || !crack.found)
+		print_error_and_exit("calloc() failed");
+	crack.mask = slots - 1;
+	for (size_t i = 0; i < crack.count; i++)
+	{
+		size_t	slot = target_slot(crack.targets + i * size);
+		if (crack.table[slot])
+			continue;
+		memmove(crack.targets + unique * size, crack.targets + i * size, size);
+		crack.table[slot] = ++unique;
+	}
+	crack.count = unique;
+	crack.remaining = unique;
+}
+
+/**
+ * Looks a computed digest up in the targets and reports it on a first match.
+ *
+ * @param digest The raw digest of the word.
+ * @param word The word.
+ * @param len The length of the word.
+ */
+static void	check_candidate(const uint8_t *digest, const char *word, size_t len)
+{
+	uint32_t	target = crack.table[target_slot(digest)];
+
+	if (!target || __atomic_exchange_n(&crack.found[target - 1], 1, __ATOMIC_RELAXED))
+		return;
+	__atomic_fetch_sub(&crack.remaining, 1, __ATOMIC_RELAXED);
+	char	hex[MAX_DIGEST_SIZE * 2 + 1];
+
+	hex_encode(digest, crack.algo->digest_size, hex);
+	hex[crack.algo->digest_size * 2] = '\0';
+	display_cracked(hex, word, len);
+}
+
+/**
+ * Writes a word padded as the only block of its message into a lane.
+ * The padding of the previous word is reused: only the bytes it left beyond
+ * the new word are cleared.
+ *
+ * @param lanes The pending candidates.
+ * @param word The word.
+ * @param len The length of the word, at most CRACK_FAST_LEN.
+ */
+static void	load_lane(crack_lanes_t *lanes, const char *word, size_t len)
+{
+	uint8_t		*block = lanes->blocks[lanes->count];
+	size_t		previous = lanes->lengths[lanes->count];
+	uint64_t	bit_len = len * 8;
+
+	memcpy(block, word, len);
+	block[len] = 0x80;
+	if (previous > len)
+		memset(block + len + 1, 0, previous - len);
+	if (crack.big_endian)
+		bit_len = __builtin_bswap64(bit_len);
+	memcpy(block + 56, &bit_len, sizeof(bit_len));
+	lanes->lengths[lanes->count] = len;
+	lanes->words[lanes->count] = word;
+	lanes->count++;
+}
+
+/**
+ * Hashes the pending candidates with one multi-lane compression and checks
+ * every resulting digest.
+ *
+ * @param lanes The pending candidates.
+ */
+static void	flush_lanes(crack_lanes_t *lanes)
+{
+	uint32_t		state[8][MB_LANES];
+	const uint8_t	*blocks[MB_LANES];
+	uint8_t			digest[MAX_DIGEST_SIZE];
+
+	for (int word = 0; word < crack.state_words; word++)
+		for (int lane = 0; lane < MB_LANES; lane++)
+			state[word][lane] = crack.iv[word];
+	for (int lane = 0; lane < MB_LANES; lane++)
+		blocks[lane] = lanes->blocks[lane];
+	crack.compress(state, blocks);
+
+	for (int lane = 0; lane < lanes->count; lane++)
+	{
+		for (int word = 0; word < crack.state_words; word++)
+		{
+			uint32_t	value = state[word][lane];
+			if (crack.big_endian)
+				value = __builtin_bswap32(value);
+			memcpy(digest + word * 4, &value, 4);
+		}
+		check_candidate(digest, lanes->words[lane], lanes->lengths[lane]);
+	}
+	lanes->count = 0;
+}
+
+/**
+ * Main loop of a worker: hashes every word of its slice of the wordlist.
+ * Short words are batched into the multi-lane kernel; longer words, and every
+ * word for algorithms without such a kernel, go through the regular digest.
+ *
+ * @param data Pointer to the crack_worker_t describing the slice.
+ * @return Always NULL.
+ */
+static void	*crack_worker(void *data)
+{
+	crack_worker_t	*worker = data;
+	crack_lanes_t	*lanes = calloc(1, sizeof(crack_lanes_t));
+	uint8_t			digest[MAX_DIGEST_SIZE];
+	const char		*pos = crack.words + worker->start;
+	const char		*end = crack.words + worker->end;
+
+	if (!lanes)
+		return (NULL);
+	while (pos < end && __atomic_load_n(&crack.remaining, __ATOMIC_RELAXED))
+	{
+		const char	*next = memchr(pos, '\n', end - pos);
+		size_t		len;
+
+		if (!next)
+			next = end;
+		len = next - pos;
+		if (len && pos[len - 1] == '\r')
+			len--;
+		if (crack.compress && len <= CRACK_FAST_LEN)
+		{
+			load_lane(lanes, pos, len);
+			if (lanes->count == MB_LANES)
+				flush_lanes(lanes);
+		}
+		else
+		{
+			crack.algo->digest((const uint8_t *)pos, len, digest);
+			check_candidate(digest, pos, len);
+		}
+		worker->tried++;
+		pos = next + 1;
+	}
+	if (lanes->count)
+		flush_lanes(lanes);
+	free(lanes);
+	return (NULL);
+}
+
+/**
+ * Moves an offset of the wordlist to the start of the line it falls in the
+ * middle of, so that no word is split between two workers.
+ *
+ * @param offset The offset in the wordlist.
+ * @return The offset of the next line start.
+ */
+static size_t	line_start(size_t offset)
+{
+	const char	*next;
+
+	if (offset == 0 || offset >= crack.words_size)
+		return (offset >= crack.words_size ? crack.words_size : 0);
+	if (crack.words[offset - 1] == '\n')
+		return (offset);
+	next = memchr(crack.words + offset, '\n', crack.words_size - offset);
+	return (next ? (size_t)(next - crack.words) + 1 : crack.words_size);
+}
+
+/**
+ * Splits the wordlist between the workers and waits for them.
+ *
+ * @return The number of words tried.
+ */
+static uint64_t	run_workers(void)
+{
+	crack_worker_t	workers[ENGINE_MAX_THREADS];
+	int				count = engine_threads();
+	int				started = 0;
+	uint64_t		tried = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		workers[i].start = line_start(crack.words_size / count * i);
+		workers[i].end = (i + 1 == count) ? crack.words_size
+			: line_start(crack.words_size / count * (i + 1));
+		workers[i].tried = 0;
+	}
+	while (started < count
+		&& pthread_create(&workers[started].thread, NULL, crack_worker, &workers[started]) == 0)
+		started++;
+	if (started == 0)
+		print_error_and_exit("pthread_create() failed");
+	for (int i = 0; i < started; i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+		tried += workers[i].tried;
+	}
+	for (int i = started; i < count; i++)
+	{
+		crack_worker(&workers[i]);
+		tried += workers[i].tried;
+	}
+	return (tried);
+}
+
+/**
+ * Selects the multi-lane kernel and initial state of the algorithm.
+ * Whirlpool has no multi-lane kernel and is always hashed word by word.
+ *
+ * @param args The request holding the algorithm.
+ */
+static void	select_kernel(const args_t *args)
+{
+	hash_ctx_t	ctx;
+
+	if (args->command == 1)
+	{
+		md5_init(&ctx.md5);
+		memcpy(crack.iv, &ctx.md5.state, sizeof(md5_group_t));
+		crack.compress = md5_compress_mb;
+		crack.state_words = 4;
+	}
+	else if (args->command == 2)
+	{
+		sha256_init_blocks(&ctx.sha256);
+		memcpy(crack.iv, ctx.sha256.state, sizeof(ctx.sha256.state));
+		crack.compress = sha256_compress_mb;
+		crack.state_words = 8;
+		crack.big_endian = 1;
+	}
+}
+
+/**
+ * Parses the arguments of the crack command.
+ * Usage: ft_ssl crack [-a md5|sha256|whirlpool] -w wordlist [hashes...]
+ *
+ * @param args The request, receiving the algorithm.
+ * @param ac The argument count.
+ * @param av The argument vector.
+ * @param wordlist Pointer receiving the path of the wordlist.
+ * @return The index of the first hash file in 'av'.
+ */
+static int	parse_crack_args(args_t *args, int ac, char **av, const char **wordlist)
+{
+	int	i = 2;
+
+	args->command = 1;
+	while (i < ac && av[i][0] == '-' && av[i][1])
+	{
+		if (strcmp(av[i], "-a") == 0 && i + 1 < ac)
+		{
+			if (!(args->command = find_algo(av[++i])))
+			{
+				fprintf(stderr, "ft_ssl: Error: '%s' is an invalid algorithm.\n", av[i]);
+				exit(1);
+			}
+		}
+		else if (strcmp(av[i], "-w") == 0 && i + 1 < ac)
+			*wordlist = av[++i];
+		else
+		{
+			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid flag.\n", av[i]);
+			exit(1);
+		}
+		i++;
+	}
+	if (!*wordlist)
+		print_error_and_exit("usage: ft_ssl crack [-a md5|sha256|whirlpool] -w wordlist [hashes...]");
+	return (i);
+}
+
+/**
+ * Recovers the words behind a list of digests with a dictionary attack.
+ * The wordlist is mapped in memory and split between one worker per core.
+ * Words fitting in a single block are padded in place and hashed MB_LANES at
+ * a time by the multi-lane kernels; every digest is looked up in a hash set
+ * of the targets. Recovered digests are printed as "hex:word", and a summary
+ * is written to stderr.
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "crack".
+ * @return 0 if every digest was recovered, 1 otherwise.
+ */
+int	crack_command(int ac, char **av)
+{
+	const char		*wordlist = NULL;
+	args_t			args;
+	int				first;
+	struct timespec	begin, done;
+	int				mapped;
+	uint64_t		tried;
+
+	args_init(&args);
+	first = parse_crack_args(&args, ac, av, &wordlist);
+	crack.algo = get_algo(args.command);
+	select_kernel(&args);
+	if (first == ac)
+		read_records(&args, "-", '\n', collect_target, NULL);
+	for (int i = first; i < ac; i++)
+		read_records(&args, av[i], '\n', collect_target, NULL);
+	build_target_set();
+	if (!crack.count)
+	{
+		fprintf(stderr, "ft_ssl: crack: no valid %s digest found\n", crack.algo->name);
+		return (1);
+	}
+	if (!(crack.words = map_file(&args, wordlist, &crack.words_size, &mapped)))
+		return (1);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	tried = run_workers();
+	clock_gettime(CLOCK_MONOTONIC, &done);
+	double	elapsed = (done.tv_sec - begin.tv_sec) + (done.tv_nsec - begin.tv_nsec) / 1e9;
+	fprintf(stderr, "ft_ssl: crack: %zu/%zu digests recovered, %llu words in %.2fs (%.0f words/s)\n",
+		crack.count - crack.remaining, crack.count, (unsigned long long)tried, elapsed,
+		elapsed > 0 ? tried / elapsed : 0);
+
+	unmap_file((char *)crack.words, crack.words_size, mapped);
+	free(crack.targets);
+	free(crack.found);
+	free(crack.table);
+	return (crack.remaining != 0);
+}
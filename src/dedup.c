@@ -0,0 +1,306 @@
+#include "../includes/ft_ssl.h"
+
+/**
+ * Request of a dedup run, shared by its files and read by the workers.
+ */
+typedef struct	dedup_s
+{
+	const args_t		*args;
+	const hash_algo_t	*algo;
+}				dedup_t;
+
+/**
+ * File considered by the duplicate finder.
+ * 'digest' first holds the digest of the head and tail of the file, then the
+ * digest of the whole file for the candidates that still collide.
+ */
+typedef struct	dedup_file_s
+{
+	const dedup_t	*dedup;
+	char			*path;
+	uint64_t		size;
+	int				valid;
+	uint8_t			digest[MAX_DIGEST_SIZE];
+}				dedup_file_t;
+
+/**
+ * Growable list of files filled concurrently by the directory walker.
+ */
+typedef struct	dedup_list_s
+{
+	pthread_mutex_t	lock;
+	const dedup_t	*dedup;
+	dedup_file_t	*files;
+	size_t			count;
+	size_t			capacity;
+}				dedup_list_t;
+
+/**
+ * Walker callback adding a non-empty file to the list.
+ *
+ * @param file The file found by the walker.
+ * @param data Pointer to the dedup_list_t being filled.
+ */
+static void	collect_file(walk_entry_t *file, void *data)
+{
+	dedup_list_t	*list = data;
+
+	if (file->size == 0)
+	{
+		free(file->path);
+		return;
+	}
+	pthread_mutex_lock(&list->lock);
+	if (list->count == list->capacity)
+	{
+		size_t			capacity = list->capacity ? list->capacity * 2 : 1024;
+		dedup_file_t	*files = realloc(list->files, capacity * sizeof(dedup_file_t));
+		if (!files)
+		{
+			pthread_mutex_unlock(&list->lock);
+			print_error(list->dedup->args, file->path, strerror(errno));
+			free(file->path);
+			return;
+		}
+		list->files = files;
+		list->capacity = capacity;
+	}
+	list->files[list->count].dedup = list->dedup;
+	list->files[list->count].path = file->path;
+	list->files[list->count].size = file->size;
+	list->files[list->count].valid = 1;
+	list->count++;
+	pthread_mutex_unlock(&list->lock);
+}
+
+/**
+ * Hashes the first and last DEDUP_PARTIAL_SIZE bytes of a file.
+ * Files smaller than twice that size are hashed entirely, which makes their
+ * partial digest final.
+ *
+ * @param path Unused, the path is owned by the file entry.
+ * @param data Pointer to the dedup_file_t to hash.
+ */
+static void	partial_hash_job(char *path, void *data)
+{
+	dedup_file_t	*file = data;
+	uint8_t			buffer[DEDUP_PARTIAL_SIZE * 2];
+	size_t			head = file->size < sizeof(buffer) ? file->size : DEDUP_PARTIAL_SIZE;
+	size_t			tail = file->size < sizeof(buffer) ? 0 : DEDUP_PARTIAL_SIZE;
+	int				fd = open(file->path, O_RDONLY);
+
+	(void)path;
+	if (fd == -1
+		|| pread(fd, buffer, head, 0) != (ssize_t)head
+		|| (tail && pread(fd, buffer + head, tail, file->size - tail) != (ssize_t)tail))
+	{
+		print_error(file->dedup->args, file->path, fd == -1 ? strerror(errno) : "Read error");
+		file->valid = 0;
+	}
+	else
+		file->dedup->algo->digest(buffer, head + tail, file->digest);
+	if (fd != -1)
+		close(fd);
+}
+
+/**
+ * Computes the digest of a whole file, streamed in chunks.
+ *
+ * @param path Unused, the path is owned by the file entry.
+ * @param data Pointer to the dedup_file_t to hash.
+ */
+static void	full_hash_job(char *path, void *data)
+{
+	dedup_file_t		*file = data;
+	const hash_algo_t	*algo = file->dedup->algo;
+	uint64_t			size = 0;
+	hash_ctx_t			ctx;
+
+	(void)path;
+	algo->init(&ctx);
+	if (hash_stream_file(file->dedup->args, file->path, algo, &ctx, &size) != 0 || size != file->size)
+		file->valid = 0;
+	else
+		algo->final(&ctx, file->digest);
+}
+
+/**
+ * qsort() comparator ordering files by size, then by digest, invalid files last.
+ */
+static int	compare_files(const void *a, const void *b)
+{
+	const dedup_file_t	*file_a = a;
+	const dedup_file_t	*file_b = b;
+
+	if (file_a->valid != file_b->valid)
+		return (file_b->valid - file_a->valid);
+	if (file_a->size != file_b->size)
+		return ((file_a->size > file_b->size) - (file_a->size < file_b->size));
+	return (memcmp(file_a->digest, file_b->digest, file_a->dedup->algo->digest_size));
+}
+
+/**
+ * qsort() comparator ordering files like compare_files(), then by path so the
+ * output is stable from one run to the next.
+ */
+static int	compare_output(const void *a, const void *b)
+{
+	int	diff = compare_files(a, b);
+
+	if (diff)
+		return (diff);
+	return (strcmp(((const dedup_file_t *)a)->path, ((const dedup_file_t *)b)->path));
+}
+
+/**
+ * Sorts the list and keeps only the files that share their size and digest
+ * with at least one other file. Dropped entries are released.
+ *
+ * @param list The list to filter.
+ */
+static void	keep_collisions(dedup_list_t *list)
+{
+	size_t	kept = 0;
+	size_t	i = 0;
+
+	qsort(list->files, list->count, sizeof(dedup_file_t), compare_files);
+	while (i < list->count)
+	{
+		size_t	j = i + 1;
+		while (j < list->count && list->files[i].valid
+			&& compare_files(&list->files[i], &list->files[j]) == 0)
+			j++;
+		for (size_t n = i; n < j; n++)
+		{
+			if (j - i > 1)
+				list->files[kept++] = list->files[n];
+			else
+				free(list->files[n].path);
+		}
+		i = j;
+	}
+	list->count = kept;
+}
+
+/**
+ * Runs a hashing pass over the whole list on the hashing workers.
+ *
+ * @param list The list of files to hash.
+ * @param run The job function to run for each file.
+ * @param min_size Files smaller than this size are skipped.
+ * @param flags The engine flags (ENGINE_DISK_ORDER).
+ */
+static void	hash_pass(dedup_list_t *list, job_function_t run, uint64_t min_size, int flags)
+{
+	engine_start(flags);
+	for (size_t i = 0; i < list->count; i++)
+	{
+		if (list->files[i].size >= min_size)
+			engine_submit(run, list->files[i].path, &list->files[i]);
+	}
+	engine_finish();
+}
+
+/**
+ * Prints the groups of duplicate files, separated by an empty line.
+ *
+ * @param list The sorted list of duplicates.
+ */
+static void	display_groups(dedup_list_t *list)
+{
+	const dedup_t	*dedup = list->dedup;
+
+	qsort(list->files, list->count, sizeof(dedup_file_t), compare_output);
+	for (size_t i = 0; i < list->count; i++)
+	{
+		char	hex[MAX_DIGEST_SIZE * 2 + 1];
+
+		hex_encode(list->files[i].digest, dedup->algo->digest_size, hex);
+		hex[dedup->algo->digest_size * 2] = '\0';
+		if (i > 0 && compare_files(&list->files[i - 1], &list->files[i]) != 0)
+			display_printf(dedup->args, "\n");
+		display_printf(dedup->args, "%s %s\n", hex, list->files[i].path);
+	}
+}
+
+/**
+ * Parses the arguments of the dedup command.
+ * Usage: ft_ssl dedup [-a md5|sha256|whirlpool] [--disk-order] directory...
+ *
+ * @param args The request, receiving the algorithm and flags.
+ * @param ac The argument count.
+ * @param av The argument vector.
+ * @return The index of the first directory in 'av'.
+ */
+static int	parse_dedup_args(args_t *args, int ac, char **av)
+{
+	int	i = 2;
+
+	args->command = 2;
+	while (i < ac && av[i][0] == '-')
+	{
+		if (strcmp(av[i], "-a") == 0 && i + 1 < ac)
+		{
+			if (!(args->command = find_algo(av[++i])))
+			{
+				fprintf(stderr, "ft_ssl: Error: '%s' is an invalid algorithm.\n", av[i]);
+				exit(1);
+			}
+		}
+		else if (strcmp(av[i], "--disk-order") == 0)
+			args->disk_order = 1;
+		else
+		{
+			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid flag.\n", av[i]);
+			exit(1);
+		}
+		i++;
+	}
+	if (i >= ac)
+		print_error_and_exit("usage: ft_ssl dedup [-a md5|sha256|whirlpool] [--disk-order] directory...");
+	return (i);
+}
+
+/**
+ * Finds duplicate files under the given directories.
+ * Files are first grouped by size, then by a digest of their first and last
+ * DEDUP_PARTIAL_SIZE bytes; only the files still colliding are hashed
+ * entirely. Groups of identical files are printed at the end.
+ * --disk-order only applies to the full pass: the partial one reads a few
+ * KiB per file, which the disk-order prefetch would turn into whole files.
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "dedup".
+ * @return Always 0.
+ */
+int	dedup_command(int ac, char **av)
+{
+	dedup_list_t	list = {PTHREAD_MUTEX_INITIALIZER, NULL, NULL, 0, 0};
+	dedup_t			dedup;
+	args_t			args;
+	int				first;
+
+	args_init(&args);
+	first = parse_dedup_args(&args, ac, av);
+	dedup.args = &args;
+	dedup.algo = get_algo(args.command);
+	list.dedup = &dedup;
+	walk_tree(&args, av + first, ac - first, WALK_STAT, collect_file, &list);
+
+	for (size_t i = 0; i < list.count; i++)
+		ft_bzero(list.files[i].digest, MAX_DIGEST_SIZE);
+	keep_collisions(&list);
+
+	hash_pass(&list, partial_hash_job, 0, 0);
+	keep_collisions(&list);
+
+	hash_pass(&list, full_hash_job, DEDUP_PARTIAL_SIZE * 2, args.disk_order ? ENGINE_DISK_ORDER : 0);
+	keep_collisions(&list);
+
+	display_groups(&list);
+	for (size_t i = 0; i < list.count; i++)
+		free(list.files[i].path);
+	free(list.files);
+	pthread_mutex_destroy(&list.lock);
+	return (0);
+}
@@ -0,0 +1,119 @@
+#include "../includes/ft_ssl.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static int	cpu_sse2(void)
+{
+	return (__builtin_cpu_supports("sse2"));
+}
+
+static int	cpu_shani(void)
+{
+	return (__builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1"));
+}
+
+#endif
+
+static int	cpu_any(void)
+{
+	return (1);
+}
+
+/**
+ * The kernel sets, from the most portable to the fastest.
+ * The SHA-NI set only brings a single-block SHA256 kernel: its multi-lane
+ * kernels (NULL here) are taken from the best vector set of the CPU.
+ * Whirlpool has a single table-driven kernel and is not dispatched.
+ * There are no AVX2 or AVX-512 sets: the multi-lane kernels are 4 lanes of
+ * 32 bits wide, so wider registers would bring nothing to them.
+ */
+static const hash_impl_t	impls[] = {
+	{"scalar", "scalar", cpu_any, md5_compress_mb_scalar,
+		sha256_compress_scalar, sha256_compress_mb_words_scalar},
+#if defined(__x86_64__) || defined(__i386__)
+	{"sse2", "sse2", cpu_sse2, md5_compress_mb_sse2,
+		sha256_compress_scalar, sha256_compress_mb_words_sse2},
+	{"shani", NULL, cpu_shani, NULL,
+		sha256_compress_shani, NULL},
+#else
+	{"simd", "simd", cpu_any, md5_compress_mb_sse2,
+		sha256_compress_scalar, sha256_compress_mb_words_sse2},
+#endif
+};
+
+#define IMPL_COUNT (sizeof(impls) / sizeof(impls[0]))
+
+static hash_impl_t	selected;
+
+/* The baseline vector set until impl_init() has run */
+const hash_impl_t	*hash_impl = &impls[1];
+
+/**
+ * Makes a kernel set the current one, completing a set without multi-lane
+ * kernels with those of the best vector set supported by the CPU.
+ * Only called before any thread is started.
+ *
+ * @param impl The kernel set.
+ */
+static void	use_impl(const hash_impl_t *impl)
+{
+	selected = *impl;
+	for (int i = IMPL_COUNT - 1; i >= 0 && !selected.md5_compress_mb; i--)
+	{
+		if (impls[i].md5_compress_mb && impls[i].supported())
+		{
+			selected.lanes = impls[i].lanes;
+			selected.md5_compress_mb = impls[i].md5_compress_mb;
+			selected.sha256_compress_mb_words = impls[i].sha256_compress_mb_words;
+		}
+	}
+	hash_impl = &selected;
+}
+
+/**
+ * Selects the kernels used by every algorithm.
+ *
+ * @param name The name of a kernel set, or NULL or "auto" for the fastest
+ * one supported by the CPU.
+ * @return 0 on success, 1 if the name is unknown, 2 if the CPU lacks the
+ * instructions of the set.
+ */
+int	impl_select(const char *name)
+{
+	if (!name || strcmp(name, "auto") == 0)
+	{
+		for (int i = IMPL_COUNT - 1; i >= 0; i--)
+		{
+			if (impls[i].supported())
+			{
+				use_impl(&impls[i]);
+				return (0);
+			}
+		}
+	}
+	for (size_t i = 0; i < IMPL_COUNT; i++)
+	{
+		if (strcmp(impls[i].name, name) == 0)
+		{
+			if (!impls[i].supported())
+				return (2);
+			use_impl(&impls[i]);
+			return (0);
+		}
+	}
+	return (1);
+}
+
+/**
+ * Selects the fastest set supported by the CPU once at startup, before
+ * main(). It reads no environment and prints nothing, since it also runs in
+ * the programs linked with the library.
+ */
+__attribute__((constructor))
+static void	impl_init(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+#endif
+	impl_select(NULL);
+}
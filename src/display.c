@@ -1,6 +1,158 @@
 #include "../includes/ft_ssl.h"
+#include <stdarg.h>
 
-extern args_t	args;
+/**
+ * Makes room for 'size' more bytes in a capture buffer.
+ *
+ * @param capture The buffer.
+ * @param size The number of bytes to append.
+ */
+static void	capture_reserve(output_buffer_t *capture, size_t size)
+{
+	size_t	capacity = capture->capacity ? capture->capacity : 256;
+	char	*grown;
+
+	if (capture->len + size <= capture->capacity)
+		return;
+	while (capacity < capture->len + size)
+		capacity *= 2;
+	if (!(grown = realloc(capture->data, capacity)))
+		print_error_and_exit("realloc() failed");
+	capture->data = grown;
+	capture->capacity = capacity;
+}
+
+/**
+ * Returns room for 'len' bytes of output of a request: at the end of its
+ * capture buffer when it has one, in the output buffer of the calling thread
+ * otherwise. Neither needs a lock: a capture buffer is only filled by the
+ * thread running its request.
+ *
+ * @param args The request.
+ * @param len The number of bytes.
+ * @return Where to write the bytes, followed by a call to display_commit().
+ */
+char	*display_reserve(const args_t *args, size_t len)
+{
+	if (!args->capture)
+		return (output_reserve(args->out, len));
+	capture_reserve(args->capture, len);
+	return (args->capture->data + args->capture->len);
+}
+
+/**
+ * Appends the bytes written after display_reserve() to the output of a request.
+ *
+ * @param args The request.
+ * @param len The number of bytes written.
+ */
+void	display_commit(const args_t *args, size_t len)
+{
+	if (args->capture)
+		args->capture->len += len;
+	else
+		output_commit(len);
+}
+
+/**
+ * Encodes a digest in the text encoding of a request: hexadecimal, or base64
+ * with --base64. Nothing is terminated or allocated.
+ *
+ * @param args The request.
+ * @param digest The digest.
+ * @param size The size of the digest.
+ * @param out The buffer receiving BASE64_SIZE(size) or 2 * size characters.
+ * @return The number of characters written.
+ */
+size_t	display_encode(const args_t *args, const uint8_t *digest, size_t size, char *out)
+{
+	if (args->encoding == ENCODING_BASE64)
+		return (base64_encode(digest, size, out));
+	hex_encode(digest, size, out);
+	return (size * 2);
+}
+
+/**
+ * Formats a message to the output of a request, from a va_list.
+ *
+ * @param args The request.
+ * @param format The printf() format.
+ * @param ap The arguments of the format.
+ */
+static void	display_vprintf(const args_t *args, const char *format, va_list ap)
+{
+	va_list	copy;
+	int		len;
+
+	va_copy(copy, ap);
+	len = vsnprintf(NULL, 0, format, copy);
+	va_end(copy);
+	if (len > 0)
+	{
+		vsnprintf(display_reserve(args, len + 1), len + 1, format, ap);
+		display_commit(args, len);
+	}
+}
+
+/**
+ * Formats a message to the output of a request.
+ *
+ * @param args The request.
+ * @param format The printf() format.
+ */
+void	display_printf(const args_t *args, const char *format, ...)
+{
+	va_list	ap;
+
+	va_start(ap, format);
+	display_vprintf(args, format, ap);
+	va_end(ap);
+}
+
+/**
+ * Formats an error message about a request.
+ * With --binary the output only holds raw digests, so the message goes to
+ * stderr instead.
+ *
+ * @param args The request.
+ * @param format The printf() format.
+ */
+static void	error_printf(const args_t *args, const char *format, ...)
+{
+	va_list	ap;
+
+	va_start(ap, format);
+	if (args->encoding == ENCODING_BINARY)
+		vfprintf(stderr, format, ap);
+	else
+		display_vprintf(args, format, ap);
+	va_end(ap);
+}
+
+/**
+ * Writes a line made of several strings to the output of a request, with a
+ * single copy of each string and no formatting.
+ *
+ * @param args The request.
+ * @param parts The strings.
+ * @param count The number of strings.
+ */
+static void	request_line(const args_t *args, const char **parts, int count)
+{
+	size_t	lens[8];
+	size_t	total = 0;
+	char	*line;
+
+	for (int i = 0; i < count; i++)
+		total += (lens[i] = strlen(parts[i]));
+	line = display_reserve(args, total);
+	for (int i = 0; i < count; i++)
+	{
+		memcpy(line, parts[i], lens[i]);
+		line += lens[i];
+	}
+	display_commit(args, total);
+}
 
 /**
  * Prints an error message to stderr and exits the program.
@@ -11,89 +163,138 @@ extern args_t	args;
  */
 void	print_error_and_exit(char *str)
 {
+	output_flush();
 	ft_printf("ft_ssl: Error: %s\n", str);
 	exit(1);
 }
 
+/**
+ * Prints an error message about a request to its output, in the format of
+ * print_error_and_exit(), without exiting. With --binary, it goes to stderr.
+ *
+ * @param args The request.
+ * @param str The error message.
+ */
+void	print_request_error(const args_t *args, char *str)
+{
+	error_printf(args, "ft_ssl: Error: %s\n", str);
+}
+
 /**
  * Prints an error message for a specific file operation.
  * The function formats and prints an error message based on the current command
  * (MD5, SHA256 or WHIRLPOOL) and the filename involved in the operation.
+ * The message goes to the output of the request, in line with its results,
+ * or to stderr with --binary.
  *
+ * @param args The request reporting the error.
  * @param filename The name of the file involved in the error.
  * @param error_msg The error message to be displayed.
  */
-void print_error(char *filename, char *error_msg)
+void print_error(const args_t *args, char *filename, char *error_msg)
 {
-	switch (args.command)
+	switch (args->command)
 	{
 		case 1:
-			ft_printf("ft_ssl: md5: %s: %s\n", filename, error_msg);
+			error_printf(args, "ft_ssl: md5: %s: %s\n", filename, error_msg);
 			break;
 		case 2:
-			ft_printf("ft_ssl: sha256: %s: %s\n", filename, error_msg);
+			error_printf(args, "ft_ssl: sha256: %s: %s\n", filename, error_msg);
 			break;
 		case 3:
-			ft_printf("ft_ssl: whirlpool: %s: %s\n", filename, error_msg);
+			error_printf(args, "ft_ssl: whirlpool: %s: %s\n", filename, error_msg);
 			break;
 		default:
-			ft_printf("ft_ssl: unknown algorithm: %s: %s\n", filename, error_msg);
+			error_printf(args, "ft_ssl: unknown algorithm: %s: %s\n", filename, error_msg);
 			break;
 	}
 }
 
+/**
+ * Displays the result of a checksum verification, in the format of GNU tools.
+ *
+ * @param args The request verifying the file.
+ * @param filename The name of the verified file.
+ * @param status The verification status ("OK", "FAILED"...).
+ */
+void	display_check(const args_t *args, char *filename, const char *status)
+{
+	request_line(args, (const char *[]){filename, ": ", status, "\n"}, 4);
+}
+
 /**
  * Displays the hash result according to the specified format.
  * This function handles different output formats based on the program's flags
  * and the type of input (standard input, string, or file).
  * It supports standard, reverse, and quiet modes for displaying the hash.
+ * The line is assembled straight into the output of the request.
  *
+ * @param args The request the hash belongs to.
  * @param hash Pointer to the computed hash string.
  * @param filename Pointer to the filename or input string associated with the hash.
  * @param type Indicator of the input source type: 1 for stdin, 2 for string, 3 for file.
  */
-void	display_hash(char *hash, char *filename, int type)
+void	display_hash(const args_t *args, char *hash, char *filename, int type)
 {
+	const char	*parts[8];
+	int			count = 0;
+
 	remove_return(filename);
-	if (args.quiet)
+	if (args->quiet)
 	{
-		if (type == 1 && args.echo)
-			ft_printf("%s\n", filename);
-		ft_printf("%s\n", hash);
+		if (type == 1 && args->echo)
+		{
+			parts[count++] = filename;
+			parts[count++] = "\n";
+		}
 	}
-	else if (args.reverse)
+	else if (args->reverse)
 	{
 		switch (type)
 		{
-			case 1: ft_printf("(\"%s\")= %s\n", filename, hash); break;
-			case 2: ft_printf("%s \"%s\"\n", hash, filename); break;
-			case 3: ft_printf("%s %s\n", hash, filename); break;
+			case 1: request_line(args, (const char *[]){"(\"", filename, "\")= ", hash, "\n"}, 5); return;
+			case 2: request_line(args, (const char *[]){hash, " \"", filename, "\"\n"}, 4); return;
+			case 3: request_line(args, (const char *[]){hash, " ", filename, "\n"}, 4); return;
 		}
 	}
 	else
 	{
-		if (type != 1)
+		switch (args->command)
 		{
-			const char*	algo_str;
-			switch (args.command)
-			{
-				case 1: algo_str = "MD5 "; break;
-				case 2: algo_str = "SHA256 "; break;
-				case 3: algo_str = "WHIRLPOOL "; break;
-			}
-			ft_printf("%s", algo_str);
+			case 1: parts[count++] = type != 1 ? "MD5 " : ""; break;
+			case 2: parts[count++] = type != 1 ? "SHA256 " : ""; break;
+			case 3: parts[count++] = type != 1 ? "WHIRLPOOL " : ""; break;
 		}
-
-		if (type == 1)
+		if (type == 1 && !args->echo)
+			parts[count++] = "(stdin)= ";
+		else
 		{
-			const char*	prefix = args.echo ? "(\"%s\")= " : "(stdin)= ";
-			ft_printf(prefix, filename);
+			parts[count++] = type == 3 ? "(" : "(\"";
+			parts[count++] = filename;
+			parts[count++] = type == 3 ? ") = " : (type == 1 ? "\")= " : "\") = ");
 		}
-		else if (type == 3)
-			ft_printf("(%s) = ", filename);
-		else
-			ft_printf("(\"%s\") = ", filename);
-
-		ft_printf("%s\n", hash);
 	}
+	parts[count++] = hash;
+	parts[count++] = "\n";
+	request_line(args, parts, count);
+}
+
+/**
+ * Displays a recovered digest and the word producing it ("hex:word").
+ * The word is written as is, so it does not need to be NUL-terminated.
+ *
+ * @param hex The hexadecimal digest.
+ * @param word The recovered word.
+ * @param len The length of the word.
+ */
+void	display_cracked(const char *hex, const char *word, size_t len)
+{
+	size_t	hex_len = strlen(hex);
+	char	*line = output_reserve(STDOUT_FILENO, hex_len + len + 2);
+
+	memcpy(line, hex, hex_len);
+	line[hex_len] = ':';
+	memcpy(line + hex_len + 1, word, len);
+	line[hex_len + len + 1] = '\n';
+	output_commit(hex_len + len + 2);
 }
@@ -0,0 +1,160 @@
+#include "../includes/ft_ssl.h"
+
+/**
+ * Converts a single byte to its hexadecimal string representation.
+ * The function maps each half-byte (nibble) of the input byte to its hexadecimal character
+ * and stores the two resulting characters in the provided string.
+ *
+ * @param byte The byte to convert to hexadecimal.
+ * @param hex_str Pointer to a char array where the hexadecimal representation will be stored.
+ */
+static void	byte_to_hex(uint8_t byte, char *hex_str)
+{
+	const char	hex_chars[] = "0123456789abcdef";
+	hex_str[0] = hex_chars[(byte >> 4) & 0x0F];
+	hex_str[1] = hex_chars[byte & 0x0F];
+}
+
+/* 16 bytes encoded at once (SSE2), 32 with AVX2 */
+typedef uint8_t	hex_vec16_t __attribute__((vector_size(16)));
+typedef uint8_t	hex_vec32_t __attribute__((vector_size(32)));
+
+/**
+ * Encodes 16 bytes as 32 hexadecimal characters.
+ * Each nibble n becomes '0' + n, plus 39 when it is above 9 (to reach 'a');
+ * the high and low nibbles are then interleaved.
+ *
+ * @param bytes The bytes.
+ * @param out The 32 characters.
+ */
+static void	hex_encode16(const uint8_t *bytes, char *out)
+{
+	hex_vec16_t	v;
+	hex_vec16_t	hi;
+	hex_vec16_t	lo;
+	hex_vec16_t	chars;
+
+	memcpy(&v, bytes, 16);
+	hi = v >> 4;
+	lo = v & 15;
+	hi += '0' + ((hex_vec16_t)(hi > 9) & 39);
+	lo += '0' + ((hex_vec16_t)(lo > 9) & 39);
+	chars = __builtin_shufflevector(hi, lo, 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+	memcpy(out, &chars, 16);
+	chars = __builtin_shufflevector(hi, lo, 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+	memcpy(out + 16, &chars, 16);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Encodes the bytes 32 at a time with AVX2.
+ *
+ * @param bytes The bytes.
+ * @param num_bytes The number of bytes.
+ * @param out The hexadecimal characters.
+ * @return The number of bytes encoded (a multiple of 32).
+ */
+__attribute__((target("avx2")))
+static size_t	hex_encode_avx2(const uint8_t *bytes, size_t num_bytes, char *out)
+{
+	size_t	i = 0;
+
+	for (; i + 32 <= num_bytes; i += 32)
+	{
+		hex_vec32_t	v;
+		hex_vec32_t	hi;
+		hex_vec32_t	lo;
+		hex_vec32_t	chars;
+
+		memcpy(&v, bytes + i, 32);
+		hi = v >> 4;
+		lo = v & 15;
+		hi += '0' + ((hex_vec32_t)(hi > 9) & 39);
+		lo += '0' + ((hex_vec32_t)(lo > 9) & 39);
+		chars = __builtin_shufflevector(hi, lo, 0, 32, 1, 33, 2, 34, 3, 35, 4, 36, 5, 37, 6, 38, 7, 39,
+			8, 40, 9, 41, 10, 42, 11, 43, 12, 44, 13, 45, 14, 46, 15, 47);
+		memcpy(out + i * 2, &chars, 32);
+		chars = __builtin_shufflevector(hi, lo, 16, 48, 17, 49, 18, 50, 19, 51, 20, 52, 21, 53, 22, 54, 23, 55,
+			24, 56, 25, 57, 26, 58, 27, 59, 28, 60, 29, 61, 30, 62, 31, 63);
+		memcpy(out + i * 2 + 32, &chars, 32);
+	}
+	return (i);
+}
+
+#endif
+
+/**
+ * Encodes bytes as lowercase hexadecimal into a caller buffer, without a
+ * terminating NUL. Whole 32-byte blocks use AVX2 when the CPU has it, whole
+ * 16-byte blocks SSE2, and the rest goes byte by byte.
+ *
+ * @param bytes The bytes.
+ * @param num_bytes The number of bytes.
+ * @param out The buffer receiving 2 * num_bytes characters.
+ */
+void	hex_encode(const uint8_t *bytes, size_t num_bytes, char *out)
+{
+	size_t	i = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+	if (num_bytes >= 32 && __builtin_cpu_supports("avx2"))
+		i = hex_encode_avx2(bytes, num_bytes, out);
+#endif
+	for (; i + 16 <= num_bytes; i += 16)
+		hex_encode16(bytes + i, out + i * 2);
+	for (; i < num_bytes; i++)
+		byte_to_hex(bytes[i], out + i * 2);
+}
+
+/**
+ * Encodes bytes as base64 (RFC 4648, with padding) into a caller buffer,
+ * without a terminating NUL.
+ *
+ * @param bytes The bytes.
+ * @param num_bytes The number of bytes.
+ * @param out The buffer receiving BASE64_SIZE(num_bytes) characters.
+ * @return The number of characters written.
+ */
+size_t	base64_encode(const uint8_t *bytes, size_t num_bytes, char *out)
+{
+	const char	alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t		len = 0;
+
+	for (size_t i = 0; i < num_bytes; i += 3)
+	{
+		uint32_t	group = (uint32_t)bytes[i] << 16;
+
+		if (i + 1 < num_bytes)
+			group |= (uint32_t)bytes[i + 1] << 8;
+		if (i + 2 < num_bytes)
+			group |= bytes[i + 2];
+		out[len++] = alphabet[group >> 18];
+		out[len++] = alphabet[(group >> 12) & 63];
+		out[len++] = i + 1 < num_bytes ? alphabet[(group >> 6) & 63] : '=';
+		out[len++] = i + 2 < num_bytes ? alphabet[group & 63] : '=';
+	}
+	return (len);
+}
+
+/**
+ * Converts an array of bytes to a hexadecimal string representation.
+ * This function allocates memory for the resulting string, which needs to be freed by the caller.
+ * Use hex_encode() to encode into an existing buffer.
+ *
+ * @param bytes Pointer to the array of bytes to be converted.
+ * @param num_bytes Number of bytes in the array.
+ * @return Pointer to a string containing the hexadecimal representation of the bytes.
+ */
+char	*bytes_to_hex_string(uint8_t *bytes, size_t num_bytes)
+{
+	char	*hex_str = malloc(num_bytes * 2 + 1);
+	if (!hex_str)
+	{
+		fprintf(stderr, "Error: malloc() failed\n");
+		return (NULL);
+	}
+	hex_encode(bytes, num_bytes, hex_str);
+	hex_str[num_bytes * 2] = '\0';
+	return (hex_str);
+}
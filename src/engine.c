@@ -0,0 +1,309 @@
+#include "../includes/ft_ssl.h"
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+
+/**
+ * Bounded job queue shared by the producers (directory walker, argument loop)
+ * and the hashing workers. Producers block when the queue is full, so the
+ * number of pending jobs never exceeds ENGINE_QUEUE_SIZE.
+ */
+typedef struct	engine_s
+{
+	pthread_mutex_t	lock;
+	pthread_cond_t	not_empty;
+	pthread_cond_t	not_full;
+	job_t			queue[ENGINE_QUEUE_SIZE];
+	size_t			head;
+	size_t			count;
+	int				closed;
+	pthread_t		threads[ENGINE_MAX_THREADS];
+	int				num_threads;
+	int				flags;
+	pthread_mutex_t	window_lock;
+	job_t			window[ENGINE_SORT_WINDOW];
+	size_t			window_count;
+	uint8_t			*prefetch;
+}				engine_t;
+
+static engine_t	engine;
+
+/**
+ * Returns the number of worker threads to use, based on the online CPUs.
+ *
+ * @return A thread count between 1 and ENGINE_MAX_THREADS.
+ */
+int	engine_threads(void)
+{
+	long	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (cpus < 1)
+		return (1);
+	if (cpus > ENGINE_MAX_THREADS)
+		return (ENGINE_MAX_THREADS);
+	return ((int)cpus);
+}
+
+/**
+ * Main loop of a hashing worker.
+ * Pops jobs from the queue and runs them until the queue is closed and drained.
+ *
+ * @param unused Unused thread argument.
+ * @return Always NULL.
+ */
+static void	*engine_worker(void *unused)
+{
+	job_t	job;
+
+	(void)unused;
+	while (1)
+	{
+		pthread_mutex_lock(&engine.lock);
+		while (engine.count == 0 && !engine.closed)
+			pthread_cond_wait(&engine.not_empty, &engine.lock);
+		if (engine.count == 0)
+		{
+			pthread_mutex_unlock(&engine.lock);
+			break;
+		}
+		job = engine.queue[engine.head];
+		engine.head = (engine.head + 1) % ENGINE_QUEUE_SIZE;
+		engine.count--;
+		pthread_cond_signal(&engine.not_full);
+		pthread_mutex_unlock(&engine.lock);
+
+		job.run(job.path, job.data);
+	}
+	return (NULL);
+}
+
+/**
+ * Starts the pool of hashing workers.
+ * With ENGINE_DISK_ORDER, submitted jobs are grouped in windows and sorted by
+ * their position on disk, then read by a single thread in that order before
+ * being queued (see engine_flush_window()).
+ * Output buffered so far by the caller is written first, so that it comes
+ * before the output of the workers.
+ * Must be paired with a call to engine_finish().
+ *
+ * @param flags 0 or ENGINE_DISK_ORDER.
+ */
+void	engine_start(int flags)
+{
+	output_flush();
+	engine.flags = flags;
+	engine.window_count = 0;
+	pthread_mutex_init(&engine.window_lock, NULL);
+	pthread_mutex_init(&engine.lock, NULL);
+	pthread_cond_init(&engine.not_empty, NULL);
+	pthread_cond_init(&engine.not_full, NULL);
+	engine.head = 0;
+	engine.count = 0;
+	engine.closed = 0;
+	engine.num_threads = 0;
+
+	int	wanted = engine_threads();
+	while (engine.num_threads < wanted)
+	{
+		if (pthread_create(&engine.threads[engine.num_threads], NULL, engine_worker, NULL) != 0)
+			break;
+		engine.num_threads++;
+	}
+	if (engine.num_threads == 0)
+		print_error_and_exit("pthread_create() failed");
+	engine.prefetch = NULL;
+	if ((flags & ENGINE_DISK_ORDER) && !(engine.prefetch = malloc(ENGINE_PREFETCH_CHUNK)))
+		print_error_and_exit("malloc() failed");
+}
+
+/**
+ * Appends a job to the queue, blocking while the queue is full.
+ *
+ * @param job The job to queue.
+ */
+static void	engine_push(const job_t *job)
+{
+	pthread_mutex_lock(&engine.lock);
+	while (engine.count == ENGINE_QUEUE_SIZE)
+		pthread_cond_wait(&engine.not_full, &engine.lock);
+	engine.queue[(engine.head + engine.count) % ENGINE_QUEUE_SIZE] = *job;
+	engine.count++;
+	pthread_cond_signal(&engine.not_empty);
+	pthread_mutex_unlock(&engine.lock);
+}
+
+/**
+ * Queues a job only if the queue has room, for callers that must not block
+ * (the event loop of serve). Not for ENGINE_DISK_ORDER pools.
+ * Ownership of 'path' is transferred to the job function on success only.
+ *
+ * @param run The function executed by a worker for this job.
+ * @param path The path of the input to process.
+ * @param data Opaque pointer passed back to the job function.
+ * @return 0 if the job was queued, -1 if the queue is full.
+ */
+int	engine_try_submit(job_function_t run, char *path, void *data)
+{
+	pthread_mutex_lock(&engine.lock);
+	if (engine.count == ENGINE_QUEUE_SIZE)
+	{
+		pthread_mutex_unlock(&engine.lock);
+		return (-1);
+	}
+	engine.queue[(engine.head + engine.count) % ENGINE_QUEUE_SIZE] = (job_t){run, path, data, 0};
+	engine.count++;
+	pthread_cond_signal(&engine.not_empty);
+	pthread_mutex_unlock(&engine.lock);
+	return (0);
+}
+
+/**
+ * Returns the physical position of the first block of a file.
+ * Uses FIEMAP to map the first extent; on file systems without FIEMAP support
+ * the inode number is used instead, as inodes tend to be allocated close to
+ * their data.
+ *
+ * @param path The path of the file.
+ * @return The sort key of the file, 0 if it cannot be opened.
+ */
+static uint64_t	job_disk_offset(const char *path)
+{
+	union
+	{
+		struct fiemap	map;
+		char			raw[sizeof(struct fiemap) + sizeof(struct fiemap_extent)];
+	}			fiemap;
+	struct stat	st;
+	uint64_t	key = 0;
+	int			fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if (fd == -1)
+		return (0);
+	ft_bzero(&fiemap, sizeof(fiemap));
+	fiemap.map.fm_length = FIEMAP_MAX_OFFSET;
+	fiemap.map.fm_extent_count = 1;
+	if (ioctl(fd, FS_IOC_FIEMAP, &fiemap.map) == 0 && fiemap.map.fm_mapped_extents > 0)
+		key = fiemap.map.fm_extents[0].fe_physical;
+	else if (fstat(fd, &st) == 0)
+		key = st.st_ino;
+	close(fd);
+	return (key);
+}
+
+/**
+ * qsort() comparator ordering jobs by ascending disk position.
+ */
+static int	compare_jobs(const void *a, const void *b)
+{
+	uint64_t	key_a = ((const job_t *)a)->key;
+	uint64_t	key_b = ((const job_t *)b)->key;
+
+	return ((key_a > key_b) - (key_a < key_b));
+}
+
+/**
+ * Reads a whole file into the page cache, so that the worker hashing it does
+ * not touch the disk.
+ *
+ * @param path The path of the file.
+ * @return 1 if the file was read, 0 if it is too large or cannot be read
+ * here (the job then reads it itself).
+ */
+static int	engine_prefetch(const char *path)
+{
+	struct stat	st;
+	ssize_t		bytes_read;
+	int			fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	st.st_mode = 0;
+	if (fd == -1)
+		return (1);
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size > ENGINE_PREFETCH_MAX)
+	{
+		close(fd);
+		return (!(S_ISREG(st.st_mode) && st.st_size > ENGINE_PREFETCH_MAX));
+	}
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	while ((bytes_read = read(fd, engine.prefetch, ENGINE_PREFETCH_CHUNK)) > 0
+		|| (bytes_read == -1 && errno == EINTR))
+		;
+	close(fd);
+	return (1);
+}
+
+/**
+ * Sorts a window of jobs by disk position and hands them over in that order.
+ * The calling thread is the only one reading the disk: it reads each file
+ * into the page cache before queuing its job, so the workers hash from memory
+ * and the disk sees one sequential sweep instead of concurrent seeks. Files
+ * too large to be cached are hashed by the calling thread itself, which
+ * keeps their reads in order as well.
+ *
+ * @param jobs The jobs to queue.
+ * @param count The number of jobs in the window.
+ */
+static void	engine_flush_window(job_t *jobs, size_t count)
+{
+	qsort(jobs, count, sizeof(job_t), compare_jobs);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (engine_prefetch(jobs[i].path))
+			engine_push(&jobs[i]);
+		else
+			jobs[i].run(jobs[i].path, jobs[i].data);
+	}
+}
+
+/**
+ * Queues a job for the hashing workers, blocking while the queue is full.
+ * In disk order mode the job is held back until its window is full.
+ * Ownership of 'path' is transferred to the job function.
+ *
+ * @param run The function executed by a worker for this job.
+ * @param path The path of the input to process.
+ * @param data Opaque pointer passed back to the job function.
+ */
+void	engine_submit(job_function_t run, char *path, void *data)
+{
+	job_t	job = {run, path, data, 0};
+
+	if (!(engine.flags & ENGINE_DISK_ORDER))
+	{
+		engine_push(&job);
+		return;
+	}
+
+	job.key = job_disk_offset(path);
+	pthread_mutex_lock(&engine.window_lock);
+	engine.window[engine.window_count++] = job;
+	if (engine.window_count == ENGINE_SORT_WINDOW)
+	{
+		engine_flush_window(engine.window, engine.window_count);
+		engine.window_count = 0;
+	}
+	pthread_mutex_unlock(&engine.window_lock);
+}
+
+/**
+ * Closes the queue, waits for the workers to drain it and releases the pool.
+ */
+void	engine_finish(void)
+{
+	engine_flush_window(engine.window, engine.window_count);
+	engine.window_count = 0;
+
+	pthread_mutex_lock(&engine.lock);
+	engine.closed = 1;
+	pthread_cond_broadcast(&engine.not_empty);
+	pthread_mutex_unlock(&engine.lock);
+
+	for (int i = 0; i < engine.num_threads; i++)
+		pthread_join(engine.threads[i], NULL);
+
+	free(engine.prefetch);
+	pthread_cond_destroy(&engine.not_full);
+	pthread_cond_destroy(&engine.not_empty);
+	pthread_mutex_destroy(&engine.lock);
+	pthread_mutex_destroy(&engine.window_lock);
+}
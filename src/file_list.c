@@ -0,0 +1,136 @@
+#include "../includes/ft_ssl.h"
+
+/**
+ * Appends a chunk of path to the pending entry, growing it as needed.
+ * Entries split across two reads are rebuilt here; this buffer only ever
+ * holds a single path, so memory stays bounded by the longest entry.
+ *
+ * @param entry Pointer to the pending entry buffer.
+ * @param len Pointer to the length of the pending entry.
+ * @param cap Pointer to the capacity of the pending entry buffer.
+ * @param src The bytes to append.
+ * @param n The number of bytes to append.
+ * @return 1 on success, 0 on allocation failure.
+ */
+static int	append_entry(char **entry, size_t *len, size_t *cap, const char *src, size_t n)
+{
+	if (*len + n + 1 > *cap)
+	{
+		size_t	new_cap = (*cap ? *cap : 256);
+		while (new_cap < *len + n + 1)
+			new_cap *= 2;
+		char	*new_entry = realloc(*entry, new_cap);
+		if (!new_entry)
+			return (0);
+		*entry = new_entry;
+		*cap = new_cap;
+	}
+	memcpy(*entry + *len, src, n);
+	*len += n;
+	(*entry)[*len] = '\0';
+	return (1);
+}
+
+/**
+ * Record callback handing a complete path to the hashing workers.
+ * Empty entries are skipped.
+ *
+ * @param entry The entry, not owned by this function.
+ * @param len The length of the entry.
+ * @param data Pointer to the job_t template (run function and data) to submit.
+ */
+static void	submit_entry(const char *entry, size_t len, void *data)
+{
+	job_t	*job = data;
+
+	if (len == 0)
+		return;
+	char	*path = malloc(len + 1);
+	if (!path)
+	{
+		perror("ft_ssl: malloc() failed");
+		return;
+	}
+	memcpy(path, entry, len);
+	path[len] = '\0';
+	engine_submit(job->run, path, job->data);
+}
+
+/**
+ * Streams the records of a file (or stdin for "-") to a callback.
+ * Records are separated by 'delimiter'. The input is read in fixed-size chunks
+ * and each record is handed over as soon as it is complete, so arbitrarily
+ * large inputs are processed with bounded memory. The last record does not
+ * need to be terminated.
+ *
+ * @param args The request reading the records (error messages).
+ * @param path The path of the file, or "-" for stdin.
+ * @param delimiter The record separator.
+ * @param on_record Callback receiving each record (not NUL-terminated).
+ * @param data Opaque pointer passed to the callback.
+ * @return 0 on success, 1 if the file could not be read.
+ */
+int	read_records(const args_t *args, const char *path, char delimiter, record_callback_t on_record, void *data)
+{
+	char	buffer[FILE_LIST_CHUNK];
+	char	*entry = NULL;
+	size_t	entry_len = 0;
+	size_t	entry_cap = 0;
+	ssize_t	bytes_read;
+	int		fd = STDIN_FILENO;
+
+	if (strcmp(path, "-") != 0 && (fd = open(path, O_RDONLY)) == -1)
+	{
+		print_error(args, (char *)path, strerror(errno));
+		return (1);
+	}
+	while ((bytes_read = read(fd, buffer, sizeof(buffer))) > 0)
+	{
+		const char	*pos = buffer;
+		const char	*end = buffer + bytes_read;
+		const char	*next;
+
+		while ((next = memchr(pos, delimiter, end - pos)))
+		{
+			if (entry_len)
+			{
+				if (append_entry(&entry, &entry_len, &entry_cap, pos, next - pos))
+					on_record(entry, entry_len, data);
+				entry_len = 0;
+			}
+			else
+				on_record(pos, next - pos, data);
+			pos = next + 1;
+		}
+		if (pos < end && !append_entry(&entry, &entry_len, &entry_cap, pos, end - pos))
+		{
+			perror("ft_ssl: malloc() failed");
+			entry_len = 0;
+		}
+	}
+	if (bytes_read == -1)
+		print_error(args, (char *)path, strerror(errno));
+	if (entry_len)
+		on_record(entry, entry_len, data);
+	free(entry);
+	if (fd != STDIN_FILENO)
+		close(fd);
+	return (bytes_read == -1);
+}
+
+/**
+ * Streams a list of paths from a file (or stdin for "-") into the hashing workers.
+ * Entries are separated by newlines, or by NUL bytes when 'delimiter' is '\0'.
+ *
+ * @param args The request reading the list (error messages).
+ * @param list The path of the list file, or "-" for stdin.
+ * @param delimiter The entry separator ('\n' or '\0').
+ * @param run The job function to run for each entry.
+ * @param data Opaque pointer passed to the job function.
+ */
+void	read_file_list(const args_t *args, const char *list, char delimiter, job_function_t run, void *data)
+{
+	job_t	job = {run, NULL, data, 0};
+
+	read_records(args, list, delimiter, submit_entry, &job);
+}
@@ -17,36 +17,6 @@ static void	md5_init_blocks(md5_group_t *ctx)
 	ctx->D = 0x10325476;
 }
 
-/**
- * Performs the padding step of the MD5 algorithm.
- * It pads the input message to ensure that its length is congruent to 448 modulo 512.
- * The padding involves adding a single bit '1' followed by as many zeros as needed to meet the length requirement,
- * and finally appending the length of the original message in bits at the end of the padded message.
- *
- * @param initial_msg Pointer to the input message.
- * @param initial_len Length of the input message in bytes.
- * @param padded_msg Pointer to the pointer where the padded message will be stored.
- * @param padded_len Pointer to the size of the padded message. This value will be set by the function.
- */
-static void	md5_pad(const uint8_t *initial_msg, size_t initial_len, uint8_t **padded_msg, size_t *padded_len)
-{
-	const size_t	block_size = 64;
-
-	*padded_len = ((((initial_len + 8) / block_size) + 1) * block_size) - 8;
-	*padded_msg = calloc(*padded_len + 64, 1);
-	if (*padded_msg == NULL)
-	{
-		fprintf(stderr, "Error: calloc() failed\n");
-		return;
-	}
-
-	memcpy(*padded_msg, initial_msg, initial_len);
-	(*padded_msg)[initial_len] = 0x80;
-
-	uint64_t	bit_len = initial_len * 8;
-	memcpy(*padded_msg + *padded_len, &bit_len, 4);
-}
-
 /**
  * Processes a single 512-bit block of the message as part of the MD5 hashing algorithm.
  * It modifies the MD5 state (A, B, C, D) based on the contents of the given block.
@@ -55,45 +25,42 @@ static void	md5_pad(const uint8_t *initial_msg, size_t initial_len, uint8_t **pa
  * @param msg Pointer to the message (or a part of the message) to be processed.
  * @param offset The offset in the message where the 512-bit block starts.
  */
-static void	md5_process_block(md5_group_t *blocks, uint8_t *msg, size_t offset)
+static void	md5_process_block(md5_group_t *blocks, const uint8_t *msg, size_t offset)
 {
-	uint32_t *w = (uint32_t *) (msg + offset);
+	const uint32_t *w = (const uint32_t *) (msg + offset);
 
 	uint32_t	a = blocks->A;
 	uint32_t	b = blocks->B;
 	uint32_t	c = blocks->C;
 	uint32_t	d = blocks->D;
 
-	uint32_t	i;
-	for(i = 0; i < 64; i++)
+	for (int i = 0; i < 16; i += 4)
 	{
-		uint32_t	f, g;
-
-		if (i < 16)
-		{
-			f = (b & c) | ((~b) & d);
-			g = i;
-		}
-		else if (i < 32)
-		{
-			f = (d & b) | ((~d) & c);
-			g = (5*i + 1) % 16;
-		}
-		else if (i < 48)
-		{
-			f = b ^ c ^ d;
-			g = (3*i + 5) % 16;
-		}
-		else
-		{
-			f = c ^ (b | (~d));
-			g = (7*i) % 16;
-		}
-		uint32_t	temp = d;
-		d = c;
-		c = b;
-		b = b + LEFTROTATE((a + f + k[i] + w[g]), r[i]);
-		a = temp;
+		MD5_STEP(F, a, b, c, d, w[i], i);
+		MD5_STEP(F, d, a, b, c, w[i + 1], i + 1);
+		MD5_STEP(F, c, d, a, b, w[i + 2], i + 2);
+		MD5_STEP(F, b, c, d, a, w[i + 3], i + 3);
+	}
+	for (int i = 16; i < 32; i += 4)
+	{
+		MD5_STEP(G, a, b, c, d, w[(5 * i + 1) % 16], i);
+		MD5_STEP(G, d, a, b, c, w[(5 * i + 6) % 16], i + 1);
+		MD5_STEP(G, c, d, a, b, w[(5 * i + 11) % 16], i + 2);
+		MD5_STEP(G, b, c, d, a, w[(5 * i + 16) % 16], i + 3);
+	}
+	for (int i = 32; i < 48; i += 4)
+	{
+		MD5_STEP(H, a, b, c, d, w[(3 * i + 5) % 16], i);
+		MD5_STEP(H, d, a, b, c, w[(3 * i + 8) % 16], i + 1);
+		MD5_STEP(H, c, d, a, b, w[(3 * i + 11) % 16], i + 2);
+		MD5_STEP(H, b, c, d, a, w[(3 * i + 14) % 16], i + 3);
+	}
+	for (int i = 48; i < 64; i += 4)
+	{
+		MD5_STEP(I, a, b, c, d, w[(7 * i) % 16], i);
+		MD5_STEP(I, d, a, b, c, w[(7 * i + 7) % 16], i + 1);
+		MD5_STEP(I, c, d, a, b, w[(7 * i + 14) % 16], i + 2);
+		MD5_STEP(I, b, c, d, a, w[(7 * i + 21) % 16], i + 3);
 	}
 	blocks->A += a;
 	blocks->B += b;
@@ -102,29 +69,176 @@ static void	md5_process_block(md5_group_t *blocks, uint8_t *msg, size_t offset)
 }
 
 /**
- * Computes the MD5 hash of the given message.
- * It first pads the message, then processes each 512-bit block, and finally returns the MD5 hash as a hexadecimal string.
+ * Scalar counterpart of the multi-lane kernels: processes the block of each
+ * lane in turn. Used on CPUs without vector units, or when forced with
+ * --impl scalar.
  *
- * @param original_msg Pointer to the original message to be hashed.
- * @param len Length of the original message in bytes.
- * @return Pointer to a string containing the hexadecimal representation of the MD5 hash. Memory for this string is dynamically allocated and should be freed by the caller.
+ * @param state The interleaved MD5 states (A, B, C, D) of the lanes.
+ * @param blocks The 64-byte block to process for each lane.
  */
-char	*my_MD5(uint8_t *original_msg, size_t len)
+void	md5_compress_mb_scalar(uint32_t state[4][MB_LANES], const uint8_t *blocks[MB_LANES])
+{
+	for (int lane = 0; lane < MB_LANES; lane++)
+	{
+		md5_group_t	group = {state[0][lane], state[1][lane], state[2][lane], state[3][lane]};
+
+		md5_process_block(&group, blocks[lane], 0);
+		state[0][lane] = group.A;
+		state[1][lane] = group.B;
+		state[2][lane] = group.C;
+		state[3][lane] = group.D;
+	}
+}
+
+/**
+ * Initializes a streaming MD5 computation.
+ *
+ * @param ctx Pointer to the md5_ctx_t structure to initialize.
+ */
+void	md5_init(md5_ctx_t *ctx)
 {
-	uint8_t	*padded_msg = NULL;
-	size_t	padded_len = 0;
+	md5_init_blocks(&ctx->state);
+	ctx->length = 0;
+}
 
-	md5_pad(original_msg, len, &padded_msg, &padded_len);
+/**
+ * Updates a streaming MD5 computation with a chunk of the message.
+ * Complete 512-bit blocks are processed straight from the input; a trailing
+ * partial block is kept in the context until more data or md5_final() comes.
+ *
+ * @param ctx Pointer to the MD5 context.
+ * @param msg Pointer to the message chunk.
+ * @param size Size of the message chunk in bytes.
+ */
+void	md5_update(md5_ctx_t *ctx, const uint8_t *msg, size_t size)
+{
+	size_t	index = ctx->length & 63;
 
+	ctx->length += size;
+	if (index)
+	{
+		size_t	left = 64 - index;
+		if (size < left)
+		{
+			memcpy(ctx->buffer + index, msg, size);
+			return;
+		}
+		memcpy(ctx->buffer + index, msg, left);
+		md5_process_block(&ctx->state, ctx->buffer, 0);
+		msg += left;
+		size -= left;
+	}
+	while (size >= 64)
+	{
+		md5_process_block(&ctx->state, msg, 0);
+		msg += 64;
+		size -= 64;
+	}
+	if (size)
+		memcpy(ctx->buffer, msg, size);
+}
+
+/**
+ * Finalizes a streaming MD5 computation.
+ * Appends the '1' bit, the zero padding and the 64-bit message length, then
+ * writes the 16-byte digest.
+ *
+ * @param ctx Pointer to the MD5 context.
+ * @param digest Buffer of at least MD5_DIGEST_SIZE bytes receiving the digest.
+ */
+void	md5_final(md5_ctx_t *ctx, uint8_t *digest)
+{
+	size_t		index = ctx->length & 63;
+	uint64_t	bit_len = ctx->length * 8;
+
+	ctx->buffer[index++] = 0x80;
+	if (index > 56)
+	{
+		memset(ctx->buffer + index, 0, 64 - index);
+		md5_process_block(&ctx->state, ctx->buffer, 0);
+		index = 0;
+	}
+	memset(ctx->buffer + index, 0, 56 - index);
+	memcpy(ctx->buffer + 56, &bit_len, 8);
+	md5_process_block(&ctx->state, ctx->buffer, 0);
+
+	memcpy(digest, &ctx->state, MD5_DIGEST_SIZE);
+}
+
+/**
+ * Computes the MD5 digest of a message short enough to be padded into a
+ * single block (at most MD5_ONEBLOCK_MAX bytes).
+ * The padded block is built on the stack and compressed once.
+ *
+ * @param msg Pointer to the message.
+ * @param len Length of the message in bytes.
+ * @param digest Buffer of at least MD5_DIGEST_SIZE bytes receiving the digest.
+ */
+void	md5_oneblock(const uint8_t *msg, size_t len, uint8_t *digest)
+{
+	uint8_t		block[64] = {0};
+	uint64_t	bit_len = len * 8;
 	md5_group_t	blocks;
+
+	memcpy(block, msg, len);
+	block[len] = 0x80;
+	memcpy(block + 56, &bit_len, 8);
 	md5_init_blocks(&blocks);
+	md5_process_block(&blocks, block, 0);
+	memcpy(digest, &blocks, MD5_DIGEST_SIZE);
+}
 
-	for(size_t offset = 0; offset < padded_len; offset += 64)
-		md5_process_block(&blocks, padded_msg, offset);
+/**
+ * Computes the raw MD5 digest of the given message.
+ * The whole blocks are processed in place; only the last one or two blocks,
+ * which hold the padding and the length, are built on the stack, so nothing
+ * is allocated whatever the length of the message.
+ *
+ * @param original_msg Pointer to the original message to be hashed.
+ * @param len Length of the original message in bytes.
+ * @param digest Buffer of at least MD5_DIGEST_SIZE bytes receiving the digest.
+ */
+void	md5_digest(const uint8_t *original_msg, size_t len, uint8_t *digest)
+{
+	uint8_t		tail[128] = {0};
+	size_t		whole = len & ~(size_t)63;
+	size_t		rest = len - whole;
+	size_t		tail_len = rest < 56 ? 64 : 128;
+	uint64_t	bit_len = len * 8;
+	md5_group_t	blocks;
+
+	if (len <= MD5_ONEBLOCK_MAX)
+	{
+		md5_oneblock(original_msg, len, digest);
+		return;
+	}
+	md5_init_blocks(&blocks);
+	for (size_t offset = 0; offset < whole; offset += 64)
+		md5_process_block(&blocks, original_msg, offset);
+
+	memcpy(tail, original_msg + whole, rest);
+	tail[rest] = 0x80;
+	memcpy(tail + tail_len - 8, &bit_len, 8);
+	for (size_t offset = 0; offset < tail_len; offset += 64)
+		md5_process_block(&blocks, tail, offset);
+
+	memcpy(digest, &blocks, MD5_DIGEST_SIZE);
+}
+
+/**
+ * Computes the MD5 hash of the given message.
+ *
+ * @param original_msg Pointer to the original message to be hashed.
+ * @param len Length of the original message in bytes.
+ * @return Pointer to a string containing the hexadecimal representation of the MD5 hash. Memory for this string is dynamically allocated and should be freed by the caller.
+ */
+char	*my_MD5(uint8_t *original_msg, size_t len)
+{
+	uint8_t	digest[MD5_DIGEST_SIZE];
 
-	free(padded_msg);
+	md5_digest(original_msg, len, digest);
 
-	char	*hex_representation = bytes_to_hex_string((uint8_t*)&blocks, sizeof(blocks));
+	char	*hex_representation = bytes_to_hex_string(digest, MD5_DIGEST_SIZE);
 
 	return (hex_representation);
 }
@@ -0,0 +1,135 @@
+#include "../includes/ft_ssl.h"
+#include "../includes/ft_md5.h"
+
+/**
+ * One 32-bit word of each lane, processed with a single vector instruction.
+ */
+typedef uint32_t	md5_vec_t __attribute__((vector_size(MB_LANES * sizeof(uint32_t))));
+
+/**
+ * Processes one 512-bit block in each of the MB_LANES lanes.
+ * The lanes are independent messages: their state words are stored
+ * interleaved (state[word][lane]) so that every MD5 step handles all the lanes
+ * with the same vector operations.
+ *
+ * @param state The interleaved MD5 states (A, B, C, D) of the lanes.
+ * @param blocks The 64-byte block to process for each lane.
+ */
+static inline
+void	md5_rounds_mb(uint32_t state[4][MB_LANES], const uint8_t *blocks[MB_LANES])
+{
+	md5_vec_t	w[16];
+	md5_vec_t	a, b, c, d;
+	md5_vec_t	save[4];
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int lane = 0; lane < MB_LANES; lane++)
+		{
+			uint32_t	word;
+			memcpy(&word, blocks[lane] + i * 4, sizeof(word));
+			w[i][lane] = word;
+		}
+	}
+	memcpy(save, state, sizeof(save));
+	a = save[0];
+	b = save[1];
+	c = save[2];
+	d = save[3];
+
+	for (int i = 0; i < 16; i += 4)
+	{
+		MD5_STEP(F, a, b, c, d, w[i], i);
+		MD5_STEP(F, d, a, b, c, w[i + 1], i + 1);
+		MD5_STEP(F, c, d, a, b, w[i + 2], i + 2);
+		MD5_STEP(F, b, c, d, a, w[i + 3], i + 3);
+	}
+	for (int i = 16; i < 32; i += 4)
+	{
+		MD5_STEP(G, a, b, c, d, w[(5 * i + 1) % 16], i);
+		MD5_STEP(G, d, a, b, c, w[(5 * i + 6) % 16], i + 1);
+		MD5_STEP(G, c, d, a, b, w[(5 * i + 11) % 16], i + 2);
+		MD5_STEP(G, b, c, d, a, w[(5 * i + 16) % 16], i + 3);
+	}
+	for (int i = 32; i < 48; i += 4)
+	{
+		MD5_STEP(H, a, b, c, d, w[(3 * i + 5) % 16], i);
+		MD5_STEP(H, d, a, b, c, w[(3 * i + 8) % 16], i + 1);
+		MD5_STEP(H, c, d, a, b, w[(3 * i + 11) % 16], i + 2);
+		MD5_STEP(H, b, c, d, a, w[(3 * i + 14) % 16], i + 3);
+	}
+	for (int i = 48; i < 64; i += 4)
+	{
+		MD5_STEP(I, a, b, c, d, w[(7 * i) % 16], i);
+		MD5_STEP(I, d, a, b, c, w[(7 * i + 7) % 16], i + 1);
+		MD5_STEP(I, c, d, a, b, w[(7 * i + 14) % 16], i + 2);
+		MD5_STEP(I, b, c, d, a, w[(7 * i + 21) % 16], i + 3);
+	}
+
+	save[0] += a;
+	save[1] += b;
+	save[2] += c;
+	save[3] += d;
+	memcpy(state, save, sizeof(save));
+}
+
+/**
+ * Multi-lane kernel built for the baseline vector unit (SSE2 on x86-64).
+ */
+void	md5_compress_mb_sse2(uint32_t state[4][MB_LANES], const uint8_t *blocks[MB_LANES])
+{
+	md5_rounds_mb(state, blocks);
+}
+
+/**
+ * Processes one 512-bit block in each of the MB_LANES lanes with the
+ * kernel selected for this CPU.
+ *
+ * @param state The interleaved MD5 states (A, B, C, D) of the lanes.
+ * @param blocks The 64-byte block to process for each lane.
+ */
+void	md5_compress_mb(uint32_t state[4][MB_LANES], const uint8_t *blocks[MB_LANES])
+{
+	hash_impl->md5_compress_mb(state, blocks);
+}
+
+/**
+ * Finishes up to MB_LANES messages sharing the same MD5 midstate with a
+ * single multi-lane compression: each lane hashes the bytes pending in the
+ * midstate followed by its own message. The pending bytes, the message and
+ * the padding must fit in one block (at most MD5_ONEBLOCK_MAX bytes).
+ *
+ * @param ctx The shared midstate, left untouched.
+ * @param msgs The messages.
+ * @param lens The lengths of the messages.
+ * @param digests Buffers of at least MD5_DIGEST_SIZE bytes receiving the digests.
+ * @param count The number of messages, at most MB_LANES.
+ */
+void	md5_final_mb(const md5_ctx_t *ctx, const uint8_t **msgs, const size_t *lens, uint8_t **digests, int count)
+{
+	uint8_t			blocks[MB_LANES][64] = {{0}};
+	const uint8_t	*lanes[MB_LANES];
+	uint32_t		state[4][MB_LANES];
+	size_t			pending = ctx->length & 63;
+
+	for (int lane = 0; lane < MB_LANES; lane++)
+	{
+		lanes[lane] = blocks[lane];
+		state[0][lane] = ctx->state.A;
+		state[1][lane] = ctx->state.B;
+		state[2][lane] = ctx->state.C;
+		state[3][lane] = ctx->state.D;
+		if (lane < count)
+		{
+			uint64_t	bit_len = (ctx->length + lens[lane]) * 8;
+			memcpy(blocks[lane], ctx->buffer, pending);
+			memcpy(blocks[lane] + pending, msgs[lane], lens[lane]);
+			blocks[lane][pending + lens[lane]] = 0x80;
+			memcpy(blocks[lane] + 56, &bit_len, 8);
+		}
+	}
+	md5_compress_mb(state, lanes);
+	for (int lane = 0; lane < count; lane++)
+		for (int word = 0; word < 4; word++)
+			memcpy(digests[lane] + word * 4, &state[word][lane], 4);
+}
@@ -26,11 +26,13 @@ void	sha256_init_blocks(sha256_group_t *p)
  * Transforms the SHA256 state based on the given data block.
  * This function processes the data in 512-bit blocks, applying the SHA256
  * algorithm's compression function to modify the state.
+ * This is the portable kernel; blocks are processed through hash_impl,
+ * which may select the SHA extensions instead.
  *
  * @param state The current state of the SHA256 hash computation.
  * @param data A 512-bit block of data to be processed.
  */
-static void	sha256_transform(uint32_t *state, const uint32_t *data)
+void	sha256_compress_scalar(uint32_t *state, const uint32_t *data)
 {
 	uint32_t	W[16];
 	unsigned	j;
@@ -48,10 +50,35 @@ static void	sha256_transform(uint32_t *state, const uint32_t *data)
 		state[j] += T[j];
 }
 
+/**
+ * Scalar counterpart of the multi-lane kernels: processes the block of each
+ * lane in turn. Used on CPUs without vector units, or when forced with
+ * --impl scalar.
+ *
+ * @param state The interleaved SHA256 states of the lanes.
+ * @param words The 16 words of the block, interleaved (words[word][lane]).
+ */
+void	sha256_compress_mb_words_scalar(uint32_t state[8][MB_LANES], const uint32_t words[16][MB_LANES])
+{
+	for (int lane = 0; lane < MB_LANES; lane++)
+	{
+		uint32_t	lane_state[8];
+		uint32_t	lane_words[16];
+
+		for (int i = 0; i < 8; i++)
+			lane_state[i] = state[i][lane];
+		for (int i = 0; i < 16; i++)
+			lane_words[i] = words[i][lane];
+		sha256_compress_scalar(lane_state, lane_words);
+		for (int i = 0; i < 8; i++)
+			state[i][lane] = lane_state[i];
+	}
+}
+
 /**
  * Writes a 512-bit block of data into the SHA256 buffer, preparing it for transformation.
- * This function converts the 64-byte buffer into a 512-bit block and calls sha256_transform
- * to process this block.
+ * This function converts the 64-byte buffer into a 512-bit block and hands it to the
+ * selected compression kernel.
  *
  * @param p The SHA256 state structure containing the current hash computation state.
  */
@@ -64,7 +91,7 @@ static void	sha256_write_byte_block(sha256_group_t *p)
 		((uint32_t)(p->buffer[i * 4 + 1]) << 16) +
 		((uint32_t)(p->buffer[i * 4 + 2]) <<  8) +
 		((uint32_t)(p->buffer[i * 4 + 3]));
-	sha256_transform(p->state, data32);
+	hash_impl->sha256_compress(p->state, data32);
 }
 
 /**
@@ -76,7 +103,7 @@ static void	sha256_write_byte_block(sha256_group_t *p)
  * @param original_msg Pointer to the message block to be hashed.
  * @param size Size of the message block in bytes.
  */
-static void	sha256_update(sha256_group_t *p, uint8_t *original_msg, size_t size)
+void	sha256_update(sha256_group_t *p, const uint8_t *original_msg, size_t size)
 {
 	uint32_t	curBufferPos = (uint32_t)p->count & 0x3F;
 	while (size > 0)
@@ -100,7 +127,7 @@ static void	sha256_update(sha256_group_t *p, uint8_t *original_msg, size_t size)
  * @param p The SHA256 state structure to finalize.
  * @param hashed Pointer to the buffer where the final hash will be stored.
  */
-static void	sha256_final(sha256_group_t *p, uint8_t *hashed)
+void	sha256_final(sha256_group_t *p, uint8_t *hashed)
 {
 	uint64_t	lenInBits = (p->count << 3);
 	uint32_t	curBufferPos = (uint32_t)p->count & 0x3F;
@@ -131,25 +158,77 @@ static void	sha256_final(sha256_group_t *p, uint8_t *hashed)
 }
 
 /**
- * Computes the SHA256 hash of the given message.
+ * Computes the SHA256 digest of a message short enough to be padded into a
+ * single block (at most SHA256_ONEBLOCK_MAX bytes).
+ * The message words are built on the stack with the length already in place
+ * and compressed once.
+ *
+ * @param msg Pointer to the message.
+ * @param len Length of the message in bytes.
+ * @param digest Buffer of at least SHA256_DIGEST_SIZE bytes receiving the digest.
+ */
+void	sha256_oneblock(const uint8_t *msg, size_t len, uint8_t *digest)
+{
+	uint8_t			block[64] = {0};
+	uint32_t		data32[16];
+	sha256_group_t	hash;
+
+	memcpy(block, msg, len);
+	block[len] = 0x80;
+	for (unsigned i = 0; i < 14; i++)
+		data32[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16)
+			| ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+	data32[14] = 0;
+	data32[15] = (uint32_t)(len * 8);
+	sha256_init_blocks(&hash);
+	hash_impl->sha256_compress(hash.state, data32);
+	for (unsigned i = 0; i < 8; i++)
+	{
+		*digest++ = (unsigned char)(hash.state[i] >> 24);
+		*digest++ = (unsigned char)(hash.state[i] >> 16);
+		*digest++ = (unsigned char)(hash.state[i] >> 8);
+		*digest++ = (unsigned char)(hash.state[i]);
+	}
+}
+
+/**
+ * Computes the raw SHA256 digest of the given message.
  * This function initializes the SHA256 state, processes the message in blocks,
- * and then finalizes the computation to produce the hash.
+ * and then finalizes the computation to produce the digest.
  *
  * @param original_msg Pointer to the original message to be hashed.
  * @param size Length of the original message in bytes.
- * @return Pointer to a string containing the hexadecimal representation of the SHA256 hash.
- *         Memory for this string is dynamically allocated and should be freed by the caller.
+ * @param digest Buffer of at least SHA256_DIGEST_SIZE bytes receiving the digest.
  */
-char	*my_SHA256(uint8_t *original_msg, size_t size)
+void	sha256_digest(const uint8_t *original_msg, size_t size, uint8_t *digest)
 {
-	uint8_t			hashed[64];
 	sha256_group_t	hash;
 
+	if (size <= SHA256_ONEBLOCK_MAX)
+	{
+		sha256_oneblock(original_msg, size, digest);
+		return;
+	}
 	sha256_init_blocks(&hash);
 	sha256_update(&hash, original_msg, size);
-	sha256_final(&hash, hashed);
+	sha256_final(&hash, digest);
+}
+
+/**
+ * Computes the SHA256 hash of the given message.
+ *
+ * @param original_msg Pointer to the original message to be hashed.
+ * @param size Length of the original message in bytes.
+ * @return Pointer to a string containing the hexadecimal representation of the SHA256 hash.
+ *         Memory for this string is dynamically allocated and should be freed by the caller.
+ */
+char	*my_SHA256(uint8_t *original_msg, size_t size)
+{
+	uint8_t	hashed[SHA256_DIGEST_SIZE];
+
+	sha256_digest(original_msg, size, hashed);
 
-	char	*representation = bytes_to_hex_string(hashed, 32);
+	char	*representation = bytes_to_hex_string(hashed, SHA256_DIGEST_SIZE);
 
 	return (representation);
 }
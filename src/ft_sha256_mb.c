@@ -0,0 +1,151 @@
+#include "../includes/ft_ssl.h"
+#include "../includes/ft_sha256.h"
+
+/**
+ * One 32-bit word of each lane, processed with a single vector instruction.
+ */
+typedef uint32_t	sha256_vec_t __attribute__((vector_size(MB_LANES * sizeof(uint32_t))));
+
+/**
+ * Lane-wise counterparts of the SHA256 bitwise functions.
+ * Ch() and Maj() only use bitwise operators and are shared with the scalar code.
+ */
+#define VROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define VS0(x) (VROTR(x, 2) ^ VROTR(x, 13) ^ VROTR(x, 22))
+#define VS1(x) (VROTR(x, 6) ^ VROTR(x, 11) ^ VROTR(x, 25))
+#define Vs0(x) (VROTR(x, 7) ^ VROTR(x, 18) ^ ((x) >> 3))
+#define Vs1(x) (VROTR(x, 17) ^ VROTR(x, 19) ^ ((x) >> 10))
+
+/**
+ * Runs the SHA256 compression function on every lane at once.
+ * The lanes are independent messages: their state words are stored
+ * interleaved (state[word][lane]) so that every round handles all the lanes
+ * with the same vector operations.
+ *
+ * @param state The interleaved SHA256 states of the lanes.
+ * @param W The message schedule, whose first 16 words hold the block.
+ */
+static inline
+void	sha256_rounds(uint32_t state[8][MB_LANES], sha256_vec_t *W)
+{
+	sha256_vec_t	T[8];
+	sha256_vec_t	save[8];
+
+	for (int i = 16; i < 64; i++)
+		W[i] = Vs1(W[i - 2]) + W[i - 7] + Vs0(W[i - 15]) + W[i - 16];
+
+	memcpy(save, state, sizeof(save));
+	memcpy(T, save, sizeof(T));
+	for (int i = 0; i < 64; i++)
+	{
+		sha256_vec_t	t1 = T[7] + VS1(T[4]) + Ch(T[4], T[5], T[6]) + K[i] + W[i];
+		sha256_vec_t	t2 = VS0(T[0]) + Maj(T[0], T[1], T[2]);
+
+		T[7] = T[6];
+		T[6] = T[5];
+		T[5] = T[4];
+		T[4] = T[3] + t1;
+		T[3] = T[2];
+		T[2] = T[1];
+		T[1] = T[0];
+		T[0] = t1 + t2;
+	}
+
+	for (int i = 0; i < 8; i++)
+		save[i] += T[i];
+	memcpy(state, save, sizeof(save));
+}
+
+/**
+ * Multi-lane kernel built for the baseline vector unit (SSE2 on x86-64).
+ *
+ * @param state The interleaved SHA256 states of the lanes.
+ * @param words The 16 words of the block, interleaved (words[word][lane]).
+ */
+void	sha256_compress_mb_words_sse2(uint32_t state[8][MB_LANES], const uint32_t words[16][MB_LANES])
+{
+	sha256_vec_t	W[64];
+
+	memcpy(W, words, 16 * sizeof(sha256_vec_t));
+	sha256_rounds(state, W);
+}
+
+/**
+ * Processes one block given as interleaved big-endian words in each of the
+ * MB_LANES lanes, with the kernel selected for this CPU. Callers chaining
+ * compressions (PBKDF2, HMAC loops) keep their data in this layout and skip
+ * the byte conversions.
+ *
+ * @param state The interleaved SHA256 states of the lanes.
+ * @param words The 16 words of the block, interleaved (words[word][lane]).
+ */
+void	sha256_compress_mb_words(uint32_t state[8][MB_LANES], const uint32_t words[16][MB_LANES])
+{
+	hash_impl->sha256_compress_mb_words(state, words);
+}
+
+/**
+ * Processes one 512-bit block in each of the MB_LANES lanes.
+ *
+ * @param state The interleaved SHA256 states of the lanes.
+ * @param blocks The 64-byte block to process for each lane.
+ */
+void	sha256_compress_mb(uint32_t state[8][MB_LANES], const uint8_t *blocks[MB_LANES])
+{
+	uint32_t	words[16][MB_LANES];
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int lane = 0; lane < MB_LANES; lane++)
+		{
+			uint32_t	word;
+			memcpy(&word, blocks[lane] + i * 4, sizeof(word));
+			words[i][lane] = __builtin_bswap32(word);
+		}
+	}
+	hash_impl->sha256_compress_mb_words(state, (const uint32_t (*)[MB_LANES])words);
+}
+
+/**
+ * Finishes up to MB_LANES messages sharing the same SHA256 midstate with a
+ * single multi-lane compression: each lane hashes the bytes pending in the
+ * midstate followed by its own message. The pending bytes, the message and
+ * the padding must fit in one block (at most SHA256_ONEBLOCK_MAX bytes).
+ *
+ * @param p The shared midstate, left untouched.
+ * @param msgs The messages.
+ * @param lens The lengths of the messages.
+ * @param digests Buffers of at least SHA256_DIGEST_SIZE bytes receiving the digests.
+ * @param count The number of messages, at most MB_LANES.
+ */
+void	sha256_final_mb(const sha256_group_t *p, const uint8_t **msgs, const size_t *lens, uint8_t **digests, int count)
+{
+	uint8_t			blocks[MB_LANES][64] = {{0}};
+	const uint8_t	*lanes[MB_LANES];
+	uint32_t		state[8][MB_LANES];
+	size_t			pending = p->count & 63;
+
+	for (int lane = 0; lane < MB_LANES; lane++)
+	{
+		lanes[lane] = blocks[lane];
+		for (int word = 0; word < 8; word++)
+			state[word][lane] = p->state[word];
+		if (lane < count)
+		{
+			uint64_t	bit_len = __builtin_bswap64((p->count + lens[lane]) * 8);
+			memcpy(blocks[lane], p->buffer, pending);
+			memcpy(blocks[lane] + pending, msgs[lane], lens[lane]);
+			blocks[lane][pending + lens[lane]] = 0x80;
+			memcpy(blocks[lane] + 56, &bit_len, 8);
+		}
+	}
+	sha256_compress_mb(state, lanes);
+	for (int lane = 0; lane < count; lane++)
+	{
+		for (int word = 0; word < 8; word++)
+		{
+			uint32_t	value = __builtin_bswap32(state[word][lane]);
+			memcpy(digests[lane] + word * 4, &value, 4);
+		}
+	}
+}
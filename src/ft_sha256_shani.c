@@ -0,0 +1,57 @@
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+#endif
+#include "../includes/ft_ssl.h"
+#include "../includes/ft_sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Transforms the SHA256 state with the SHA extensions (SHA-NI).
+ * sha256rnds2 runs two rounds on a state split in two registers, ABEF and
+ * CDGH, so the state is reordered on the way in and out; sha256msg1 and
+ * sha256msg2 extend the message schedule four words at a time.
+ *
+ * @param state The current state of the SHA256 hash computation.
+ * @param data The 16 big-endian words of the block.
+ */
+__attribute__((target("sha,sse4.1")))
+void	sha256_compress_shani(uint32_t *state, const uint32_t *data)
+{
+	__m128i	abef;
+	__m128i	cdgh;
+	__m128i	abef_save;
+	__m128i	cdgh_save;
+	__m128i	tmp;
+	__m128i	w[16];
+
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0xB1);
+	cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(state + 4)), 0x1B);
+	abef = _mm_alignr_epi8(tmp, cdgh, 8);
+	cdgh = _mm_blend_epi16(cdgh, tmp, 0xF0);
+	abef_save = abef;
+	cdgh_save = cdgh;
+
+	for (int i = 0; i < 16; i++)
+	{
+		__m128i	msg;
+
+		if (i < 4)
+			w[i] = _mm_loadu_si128((const __m128i *)(data + i * 4));
+		else
+			w[i] = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(w[i - 4], w[i - 3]),
+				_mm_alignr_epi8(w[i - 1], w[i - 2], 4)), w[i - 1]);
+		msg = _mm_add_epi32(w[i], _mm_loadu_si128((const __m128i *)(K + i * 4)));
+		cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);
+		abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(msg, 0x0E));
+	}
+
+	abef = _mm_add_epi32(abef, abef_save);
+	cdgh = _mm_add_epi32(cdgh, cdgh_save);
+	tmp = _mm_shuffle_epi32(abef, 0x1B);
+	cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+	_mm_storeu_si128((__m128i *)state, _mm_blend_epi16(tmp, cdgh, 0xF0));
+	_mm_storeu_si128((__m128i *)(state + 4), _mm_alignr_epi8(cdgh, tmp, 8));
+}
+
+#endif
@@ -1,56 +1,18 @@
 #include "../includes/ft_ssl.h"
-
-extern args_t	args;
-
-/**
- * Converts a single byte to its hexadecimal string representation.
- * The function maps each half-byte (nibble) of the input byte to its hexadecimal character
- * and stores the two resulting characters in the provided string.
- *
- * @param byte The byte to convert to hexadecimal.
- * @param hex_str Pointer to a char array where the hexadecimal representation will be stored.
- */
-static void	byte_to_hex(uint8_t byte, char *hex_str)
-{
-	const char	hex_chars[] = "0123456789abcdef";
-	hex_str[0] = hex_chars[(byte >> 4) & 0x0F];
-	hex_str[1] = hex_chars[byte & 0x0F];
-}
-
-/**
- * Converts an array of bytes to a hexadecimal string representation.
- * This function allocates memory for the resulting string, which needs to be freed by the caller.
- * Each byte in the array is converted to its hexadecimal representation.
- *
- * @param bytes Pointer to the array of bytes to be converted.
- * @param num_bytes Number of bytes in the array.
- * @return Pointer to a string containing the hexadecimal representation of the bytes.
- */
-char	*bytes_to_hex_string(uint8_t *bytes, size_t num_bytes)
-{
-	char	*hex_str = malloc(num_bytes * 2 + 1);
-	if (!hex_str)
-	{
-		ft_putstr_fd("Error: malloc() failed\n", STDERR_FILENO);
-		return (NULL);
-	}
-	for (size_t i = 0; i < num_bytes; i++)
-		byte_to_hex(bytes[i], &hex_str[i * 2]);
-
-	hex_str[num_bytes * 2] = '\0';
-	return (hex_str);
-}
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /**
  * Reads the contents of a binary file or stdin into a dynamically allocated buffer.
  * The function attempts to open and read the entire content of a specified file, or stdin if no filename is provided.
  * It handles errors gracefully and prints relevant error messages. The buffer size grows dynamically as more data is read.
  *
+ * @param args The request reading the file (error messages).
  * @param filename The name of the file to read, or NULL to read from stdin.
  * @param size Pointer to a variable where the size of the read content will be stored.
  * @return Pointer to a dynamically allocated buffer containing the file's contents.
  */
-uint8_t	*read_binary_file(const char *filename, size_t *size)
+uint8_t	*read_binary_file(const args_t *args, const char *filename, size_t *size)
 {
 	const size_t	buffer_size = 1024;
 	int				fd;
@@ -61,7 +23,7 @@ uint8_t	*read_binary_file(const char *filename, size_t *size)
 		fd = open(filename, O_RDONLY);
 	if (fd == -1)
 	{
-		print_error((char *)filename, strerror(errno));
+		print_error(args, (char *)filename, strerror(errno));
 		return (NULL);
 	}
 
@@ -92,7 +54,7 @@ uint8_t	*read_binary_file(const char *filename, size_t *size)
 
 	if (bytes_read == -1)
 	{
-		print_error((char *)filename, strerror(errno));
+		print_error(args, (char *)filename, strerror(errno));
 		free(buffer);
 		close(fd);
 		return (NULL);
@@ -103,6 +65,103 @@ uint8_t	*read_binary_file(const char *filename, size_t *size)
 	return (buffer);
 }
 
+/**
+ * Streams a file (or stdin) into a hash computation, through the scratch
+ * arena of the calling thread: only FILE_CHUNK_SIZE bytes are held at once,
+ * whatever the size of the file, and nothing is allocated per file.
+ *
+ * @param args The request reading the file (error messages).
+ * @param path The path of the file, or NULL to read stdin.
+ * @param algo The hash algorithm.
+ * @param ctx The computation, already initialized, updated with the file.
+ * @param size Pointer receiving the number of bytes hashed, or NULL.
+ * @return 0 on success, 1 if the file could not be read (error printed).
+ */
+int	hash_stream_file(const args_t *args, const char *path, const hash_algo_t *algo,
+	hash_ctx_t *ctx, uint64_t *size)
+{
+	uint8_t		*chunk = arena_scratch(FILE_CHUNK_SIZE);
+	uint64_t	total = 0;
+	ssize_t		bytes_read;
+	int			fd = path ? open(path, O_RDONLY) : STDIN_FILENO;
+
+	if (fd == -1)
+	{
+		print_error(args, (char *)path, strerror(errno));
+		return (1);
+	}
+	while ((bytes_read = read(fd, chunk, FILE_CHUNK_SIZE)) != 0)
+	{
+		if (bytes_read == -1 && errno == EINTR)
+			continue;
+		if (bytes_read == -1)
+			break;
+		algo->update(ctx, chunk, bytes_read);
+		total += bytes_read;
+	}
+	if (bytes_read == -1)
+		print_error(args, path ? (char *)path : "stdin", strerror(errno));
+	if (path)
+		close(fd);
+	if (size)
+		*size = total;
+	return (bytes_read == -1);
+}
+
+/**
+ * Maps a whole file in memory, falling back to a plain read for pipes and stdin.
+ *
+ * @param args The request reading the file (error messages).
+ * @param path The path of the file, or "-" for stdin.
+ * @param size Pointer receiving the size of the file.
+ * @param mapped Pointer set to 1 when the returned buffer is a mapping.
+ * @return Pointer to the file content, to be released with unmap_file(), or NULL on error.
+ */
+char	*map_file(const args_t *args, const char *path, size_t *size, int *mapped)
+{
+	struct stat	st;
+	char		*content;
+	int			fd;
+
+	*mapped = 0;
+	if (strcmp(path, "-") == 0)
+		return ((char *)read_binary_file(args, NULL, size));
+	if ((fd = open(path, O_RDONLY)) == -1)
+	{
+		print_error(args, (char *)path, strerror(errno));
+		return (NULL);
+	}
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+	{
+		content = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (content != MAP_FAILED)
+		{
+			madvise(content, st.st_size, MADV_SEQUENTIAL);
+			close(fd);
+			*size = st.st_size;
+			*mapped = 1;
+			return (content);
+		}
+	}
+	close(fd);
+	return ((char *)read_binary_file(args, path, size));
+}
+
+/**
+ * Releases a buffer returned by map_file().
+ *
+ * @param content The file content.
+ * @param size The size of the file.
+ * @param mapped Whether the content is a mapping.
+ */
+void	unmap_file(char *content, size_t size, int mapped)
+{
+	if (mapped)
+		munmap(content, size);
+	else
+		free(content);
+}
+
 /**
  * Removes the trailing newline character from a string, if present.
  * This function checks the last character of the string and replaces it with
@@ -116,3 +175,42 @@ void	remove_return(char *str)
 	if (str[len - 1] == '\n')
 		str[len - 1] = '\0';
 }
+
+/**
+ * Converts a single hexadecimal character to its value.
+ *
+ * @param c The character to convert.
+ * @return The value of the character (0-15), or -1 if it is not a hexadecimal digit.
+ */
+static int	hex_value(char c)
+{
+	if (c >= '0' && c <= '9')
+		return (c - '0');
+	if (c >= 'a' && c <= 'f')
+		return (c - 'a' + 10);
+	if (c >= 'A' && c <= 'F')
+		return (c - 'A' + 10);
+	return (-1);
+}
+
+/**
+ * Converts a hexadecimal string to raw bytes.
+ * Exactly 'num_bytes' * 2 characters are read from 'hex'; both cases are accepted.
+ *
+ * @param hex Pointer to the hexadecimal characters.
+ * @param num_bytes Number of bytes to produce.
+ * @param bytes Buffer receiving the decoded bytes.
+ * @return 1 on success, 0 if a character is not a hexadecimal digit.
+ */
+int	hex_string_to_bytes(const char *hex, size_t num_bytes, uint8_t *bytes)
+{
+	for (size_t i = 0; i < num_bytes; i++)
+	{
+		int	high = hex_value(hex[i * 2]);
+		int	low = hex_value(hex[i * 2 + 1]);
+		if (high < 0 || low < 0)
+			return (0);
+		bytes[i] = (uint8_t)((high << 4) | low);
+	}
+	return (1);
+}
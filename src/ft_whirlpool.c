@@ -60,10 +60,10 @@ static void	swap_copy_str_to_u64(void* to, int index, const void* from, size_t l
  *
  * @param ctx Pointer to the whirlpool_ctx structure representing the hashing context.
  */
-static void	whirlpool_init(struct whirlpool_ctx* ctx)
+void	whirlpool_init(struct whirlpool_ctx* ctx)
 {
 	ctx->length = 0;
-	ft_memset(ctx->hash, 0, sizeof(ctx->hash));
+	memset(ctx->hash, 0, sizeof(ctx->hash));
 }
 
 /**
@@ -150,7 +150,7 @@ static void	whirlpool_process_block(uint64_t* hash, uint64_t* p_block)
  * @param msg Pointer to the message chunk to be hashed.
  * @param size Size of the message chunk in bytes.
  */
-static void	whirlpool_update(whirlpool_ctx* ctx, const unsigned char* msg, size_t size)
+void	whirlpool_update(whirlpool_ctx* ctx, const unsigned char* msg, size_t size)
 {
 	unsigned	index = (unsigned)ctx->length & 63;
 	unsigned	left;
@@ -159,7 +159,7 @@ static void	whirlpool_update(whirlpool_ctx* ctx, const unsigned char* msg, size_
 	if (index)
 	{
 		left = whirlpool_block_size - index;
-		ft_memcpy(ctx->message + index, msg, (size < left ? size : left));
+		memcpy(ctx->message + index, msg, (size < left ? size : left));
 		if (size < left)
 			return;
 
@@ -174,7 +174,7 @@ static void	whirlpool_update(whirlpool_ctx* ctx, const unsigned char* msg, size_
 			aligned_message_block = (uint64_t*)msg;
 		else
 		{
-			ft_memcpy(ctx->message, msg, whirlpool_block_size);
+			memcpy(ctx->message, msg, whirlpool_block_size);
 			aligned_message_block = (uint64_t*)ctx->message;
 		}
 
@@ -183,7 +183,7 @@ static void	whirlpool_update(whirlpool_ctx* ctx, const unsigned char* msg, size_
 		size -= whirlpool_block_size;
 	}
 	if (size)
-		ft_memcpy(ctx->message, msg, size);
+		memcpy(ctx->message, msg, size);
 }
 
 /**
@@ -194,7 +194,7 @@ static void	whirlpool_update(whirlpool_ctx* ctx, const unsigned char* msg, size_
  * @param ctx Pointer to the Whirlpool hashing context.
  * @param result Buffer where the final hash will be stored.
  */
-static void	whirlpool_final(whirlpool_ctx* ctx, unsigned char* result)
+void	whirlpool_final(whirlpool_ctx* ctx, unsigned char* result)
 {
 	unsigned	index = (unsigned)ctx->length & 63;
 	uint64_t*	msg64 = (uint64_t*)ctx->message;
@@ -221,22 +221,61 @@ static void	whirlpool_final(whirlpool_ctx* ctx, unsigned char* result)
 }
 
 /**
- * Computes the Whirlpool hash of a given message.
+ * Computes the Whirlpool digest of a message short enough to be padded into a
+ * single block (at most WHIRLPOOL_ONEBLOCK_MAX bytes).
+ * The padded block is built on the stack and processed once.
+ *
+ * @param msg Pointer to the message.
+ * @param len Length of the message in bytes.
+ * @param digest Buffer of at least WHIRLPOOL_DIGEST_SIZE bytes receiving the digest.
+ */
+void	whirlpool_oneblock(const uint8_t *msg, size_t len, uint8_t *digest)
+{
+	uint64_t	block[8] = {0};
+	uint64_t	hash[8] = {0};
+
+	memcpy(block, msg, len);
+	((unsigned char *)block)[len] = 0x80;
+	block[7] = bswap_64((uint64_t)len << 3);
+	whirlpool_process_block(hash, block);
+	swap_copy_str_to_u64(digest, 0, hash, 64);
+}
+
+/**
+ * Computes the raw Whirlpool digest of a given message.
  * This function initializes the hashing context, processes the message, and finalizes
- * the hash, returning the hexadecimal representation of the hash.
+ * the hash into the caller's buffer.
  *
  * @param original_msg Pointer to the message to be hashed.
  * @param size Size of the message in bytes.
- * @return A string representing the hexadecimal value of the computed hash.
+ * @param digest Buffer of at least WHIRLPOOL_DIGEST_SIZE bytes receiving the digest.
  */
-char	*my_WHIRLPOOL(uint8_t *original_msg, size_t size)
+void	whirlpool_digest(const uint8_t *original_msg, size_t size, uint8_t *digest)
 {
-	uint8_t			hash[WHIRLPOOL_DIGEST_SIZE];
 	whirlpool_ctx	ctx;
 
+	if (size <= WHIRLPOOL_ONEBLOCK_MAX)
+	{
+		whirlpool_oneblock(original_msg, size, digest);
+		return;
+	}
 	whirlpool_init(&ctx);
 	whirlpool_update(&ctx, (const unsigned char*)original_msg, size);
-	whirlpool_final(&ctx, hash);
+	whirlpool_final(&ctx, digest);
+}
+
+/**
+ * Computes the Whirlpool hash of a given message.
+ *
+ * @param original_msg Pointer to the message to be hashed.
+ * @param size Size of the message in bytes.
+ * @return A string representing the hexadecimal value of the computed hash.
+ */
+char	*my_WHIRLPOOL(uint8_t *original_msg, size_t size)
+{
+	uint8_t	hash[WHIRLPOOL_DIGEST_SIZE];
+
+	whirlpool_digest(original_msg, size, hash);
 
 	char	*hex_representation = bytes_to_hex_string((uint8_t*)&hash, sizeof(hash));
 
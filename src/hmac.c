@@ -0,0 +1,333 @@
+#include "../includes/ft_ssl.h"
+
+/**
+ * Block size of every supported algorithm, which is also the HMAC key size.
+ */
+#define HMAC_BLOCK_SIZE 64
+
+/**
+ * Number of messages authenticated together by hmac_batch().
+ */
+#define HMAC_BATCH 256
+
+/**
+ * Keyed state of an HMAC run.
+ * 'inner' and 'outer' hold the state after the key XORed with the ipad and
+ * opad constants: they are computed once per key and cloned for every message.
+ */
+typedef struct	hmac_s
+{
+	const args_t		*args;
+	const hash_algo_t	*algo;
+	hash_ctx_t			inner;
+	hash_ctx_t			outer;
+}				hmac_t;
+
+/**
+ * Lines read with --lines, copied into one buffer until the batch is full.
+ */
+typedef struct	hmac_lines_s
+{
+	const hmac_t	*hmac;
+	char			*buffer;
+	size_t			size;
+	size_t			capacity;
+	size_t			offsets[HMAC_BATCH];
+	size_t			lens[HMAC_BATCH];
+	size_t			count;
+}				hmac_lines_t;
+
+/**
+ * Precomputes the inner and outer pad states of a key.
+ * Keys longer than a block are hashed first, as required by RFC 2104.
+ *
+ * @param algo The underlying hash algorithm.
+ * @param key The key.
+ * @param len The length of the key.
+ * @param inner The context receiving the state after key ^ ipad.
+ * @param outer The context receiving the state after key ^ opad.
+ */
+void	hmac_init(const hash_algo_t *algo, const uint8_t *key, size_t len, hash_ctx_t *inner, hash_ctx_t *outer)
+{
+	uint8_t	block[HMAC_BLOCK_SIZE] = {0};
+	uint8_t	pad[HMAC_BLOCK_SIZE];
+
+	if (len > HMAC_BLOCK_SIZE)
+		algo->digest(key, len, block);
+	else
+		memcpy(block, key, len);
+	for (int i = 0; i < HMAC_BLOCK_SIZE; i++)
+		pad[i] = block[i] ^ 0x36;
+	midstate_init(algo, pad, HMAC_BLOCK_SIZE, inner);
+	for (int i = 0; i < HMAC_BLOCK_SIZE; i++)
+		pad[i] = block[i] ^ 0x5c;
+	midstate_init(algo, pad, HMAC_BLOCK_SIZE, outer);
+}
+
+/**
+ * Computes the HMAC of a batch of messages.
+ * Both passes start from the precomputed pad states and go through
+ * midstate_digest_batch(): short messages and every outer pass (a single
+ * digest after the opad block) are finished several at a time by the
+ * multi-lane kernels.
+ *
+ * @param hmac The keyed state.
+ * @param msgs The messages.
+ * @param lens The lengths of the messages.
+ * @param macs Buffers of at least digest_size bytes receiving the MACs.
+ * @param count The number of messages.
+ */
+static void	hmac_batch(const hmac_t *hmac, const uint8_t **msgs, const size_t *lens, uint8_t **macs, size_t count)
+{
+	uint8_t			inner[HMAC_BATCH][MAX_DIGEST_SIZE];
+	const uint8_t	*inner_msgs[HMAC_BATCH];
+	uint8_t			*inner_digests[HMAC_BATCH];
+	size_t			inner_lens[HMAC_BATCH];
+
+	for (size_t i = 0; i < HMAC_BATCH; i++)
+	{
+		inner_msgs[i] = inner[i];
+		inner_digests[i] = inner[i];
+		inner_lens[i] = hmac->algo->digest_size;
+	}
+	while (count > 0)
+	{
+		size_t	n = count < HMAC_BATCH ? count : HMAC_BATCH;
+
+		midstate_digest_batch(hmac->algo, &hmac->inner, msgs, lens, inner_digests, n);
+		midstate_digest_batch(hmac->algo, &hmac->outer, inner_msgs, inner_lens, macs, n);
+		msgs += n;
+		lens += n;
+		macs += n;
+		count -= n;
+	}
+}
+
+/**
+ * Displays a MAC in the format selected by the -q and -r flags.
+ * The MACs of --lines are displayed alone, one per line.
+ *
+ * @param hmac The keyed state.
+ * @param mac The raw MAC.
+ * @param name The name of the message (string or file name), or NULL.
+ * @param type Indicator of the input source type: 1 for stdin, 2 for string, 3 for file, 4 for a line.
+ */
+static void	display_mac(const hmac_t *hmac, const uint8_t *mac, char *name, int type)
+{
+	char	hex[MAX_DIGEST_SIZE * 2 + 1];
+
+	hex_encode(mac, hmac->algo->digest_size, hex);
+	hex[hmac->algo->digest_size * 2] = '\0';
+	if (hmac->args->quiet || type == 4 || (hmac->args->reverse && type == 1))
+		display_printf(hmac->args, "%s\n", hex);
+	else if (hmac->args->reverse)
+		display_printf(hmac->args, type == 2 ? "%s \"%s\"\n" : "%s %s\n", hex, name);
+	else if (type == 1)
+		display_printf(hmac->args, "HMAC-%s (stdin) = %s\n", (char *)hmac->algo->label, hex);
+	else
+		display_printf(hmac->args, type == 2 ? "HMAC-%s (\"%s\") = %s\n" : "HMAC-%s (%s) = %s\n",
+			(char *)hmac->algo->label, name, hex);
+}
+
+/**
+ * Authenticates the pending lines and prints their MACs in order.
+ *
+ * @param lines The pending lines, emptied by this function.
+ */
+static void	flush_lines(hmac_lines_t *lines)
+{
+	const uint8_t	*msgs[HMAC_BATCH];
+	uint8_t			macs[HMAC_BATCH][MAX_DIGEST_SIZE];
+	uint8_t			*outputs[HMAC_BATCH];
+
+	for (size_t i = 0; i < lines->count; i++)
+	{
+		msgs[i] = (const uint8_t *)lines->buffer + lines->offsets[i];
+		outputs[i] = macs[i];
+	}
+	hmac_batch(lines->hmac, msgs, lines->lens, outputs, lines->count);
+	for (size_t i = 0; i < lines->count; i++)
+		display_mac(lines->hmac, macs[i], NULL, 4);
+	lines->count = 0;
+	lines->size = 0;
+}
+
+/**
+ * Record callback adding a line to the pending batch.
+ *
+ * @param line The line, not NUL-terminated.
+ * @param len The length of the line.
+ * @param data Pointer to the hmac_lines_t batch.
+ */
+static void	collect_line(const char *line, size_t len, void *data)
+{
+	hmac_lines_t	*lines = data;
+
+	if (len && line[len - 1] == '\r')
+		len--;
+	if (lines->size + len > lines->capacity)
+	{
+		size_t	capacity = lines->capacity ? lines->capacity : 4096;
+		while (capacity < lines->size + len)
+			capacity *= 2;
+		char	*buffer = realloc(lines->buffer, capacity);
+		if (!buffer)
+			print_error_and_exit("realloc() failed");
+		lines->buffer = buffer;
+		lines->capacity = capacity;
+	}
+	memcpy(lines->buffer + lines->size, line, len);
+	lines->offsets[lines->count] = lines->size;
+	lines->lens[lines->count] = len;
+	lines->size += len;
+	if (++lines->count == HMAC_BATCH)
+		flush_lines(lines);
+}
+
+/**
+ * Authenticates every line of a file (or stdin for "-"), one MAC per line.
+ *
+ * @param hmac The keyed state.
+ * @param path The path of the file.
+ * @return 0 on success, 1 if the file could not be read.
+ */
+static int	hmac_lines(const hmac_t *hmac, const char *path)
+{
+	hmac_lines_t	lines;
+	int				ret;
+
+	ft_bzero(&lines, sizeof(lines));
+	lines.hmac = hmac;
+	ret = read_records(hmac->args, path, '\n', collect_line, &lines);
+	if (lines.count)
+		flush_lines(&lines);
+	free(lines.buffer);
+	return (ret);
+}
+
+/**
+ * Authenticates a whole file (or stdin when 'path' is NULL).
+ * The file is streamed into a clone of the inner pad state, then its digest
+ * goes through a clone of the outer one.
+ *
+ * @param hmac The keyed state.
+ * @param path The path of the file, or NULL for stdin.
+ * @return 0 on success, 1 if the file could not be read.
+ */
+static int	hmac_file(const hmac_t *hmac, char *path)
+{
+	hash_ctx_t	ctx = hmac->inner;
+	uint8_t		mac[MAX_DIGEST_SIZE];
+
+	if (hash_stream_file(hmac->args, path, hmac->algo, &ctx, NULL) != 0)
+		return (1);
+	hmac->algo->final(&ctx, mac);
+	ctx = hmac->outer;
+	hmac->algo->update(&ctx, mac, hmac->algo->digest_size);
+	hmac->algo->final(&ctx, mac);
+	display_mac(hmac, mac, path, path ? 3 : 1);
+	return (0);
+}
+
+/**
+ * Parses the arguments of the hmac command.
+ * Usage: ft_ssl hmac [-a algo] -k key [-q] [-r] [--lines file] [-s string]... [file...]
+ *
+ * @param args The request, receiving the algorithm, flags and strings.
+ * @param ac The argument count.
+ * @param av The argument vector.
+ * @param key Pointer receiving the key.
+ * @param lines Pointer receiving the --lines file.
+ * @return The index of the first file in 'av'.
+ */
+static int	parse_hmac_args(args_t *args, int ac, char **av, char **key, char **lines)
+{
+	int	i = 2;
+
+	args->command = 2;
+	while (i < ac && av[i][0] == '-' && av[i][1])
+	{
+		if (strcmp(av[i], "-a") == 0 && i + 1 < ac)
+		{
+			if (!(args->command = find_algo(av[++i])))
+			{
+				fprintf(stderr, "ft_ssl: Error: '%s' is an invalid algorithm.\n", av[i]);
+				exit(1);
+			}
+		}
+		else if (strcmp(av[i], "-k") == 0 && i + 1 < ac)
+			*key = av[++i];
+		else if (strcmp(av[i], "--lines") == 0 && i + 1 < ac)
+			*lines = av[++i];
+		else if (strcmp(av[i], "-s") == 0 && i + 1 < ac)
+		{
+			if (args->num_strings >= MAX_STRINGS - 1)
+				print_error_and_exit("too many strings.");
+			args->strings[args->num_strings++] = av[++i];
+		}
+		else if (strcmp(av[i], "-q") == 0)
+			args->quiet = 1;
+		else if (strcmp(av[i], "-r") == 0)
+			args->reverse = 1;
+		else
+		{
+			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid flag.\n", av[i]);
+			exit(1);
+		}
+		i++;
+	}
+	if (!*key)
+		print_error_and_exit("usage: ft_ssl hmac [-a md5|sha256|whirlpool] -k key [-q] [-r] [--lines file] [-s string]... [file...]");
+	return (i);
+}
+
+/**
+ * Computes keyed-hash message authentication codes (RFC 2104).
+ * The pad states of the key are computed once and reused for every message;
+ * the strings and the lines of --lines are authenticated in batches that
+ * feed the multi-lane kernels.
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "hmac".
+ * @return 0 on success, 1 if an input could not be read.
+ */
+int	hmac_command(int ac, char **av)
+{
+	char	*key = NULL;
+	char	*lines = NULL;
+	hmac_t	hmac;
+	args_t	args;
+	int		first;
+	int		ret = 0;
+
+	args_init(&args);
+	first = parse_hmac_args(&args, ac, av, &key, &lines);
+	hmac.args = &args;
+	hmac.algo = get_algo(args.command);
+	hmac_init(hmac.algo, (const uint8_t *)key, strlen(key), &hmac.inner, &hmac.outer);
+
+	if (args.num_strings)
+	{
+		const uint8_t	*msgs[MAX_STRINGS];
+		size_t			lens[MAX_STRINGS];
+		uint8_t			macs[MAX_STRINGS][MAX_DIGEST_SIZE];
+		uint8_t			*outputs[MAX_STRINGS];
+
+		for (int i = 0; i < args.num_strings; i++)
+		{
+			msgs[i] = (const uint8_t *)args.strings[i];
+			lens[i] = strlen(args.strings[i]);
+			outputs[i] = macs[i];
+		}
+		hmac_batch(&hmac, msgs, lens, outputs, args.num_strings);
+		for (int i = 0; i < args.num_strings; i++)
+			display_mac(&hmac, macs[i], args.strings[i], 2);
+	}
+	if (lines)
+		ret |= hmac_lines(&hmac, lines);
+	for (int i = first; i < ac; i++)
+		ret |= hmac_file(&hmac, av[i]);
+	if (!args.num_strings && !lines && first == ac)
+		ret |= hmac_file(&hmac, NULL);
+	return (ret);
+}
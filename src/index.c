@@ -0,0 +1,490 @@
+#include "../includes/ft_ssl.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Header of an index file. It is followed by the Bloom filter
+ * (bloom_bits / 8 bytes) and by the sorted digests (count * digest_size bytes).
+ */
+typedef struct	index_header_s
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	digest_size;
+	uint64_t	count;
+	uint64_t	bloom_bits;
+	uint32_t	bloom_hashes;
+	uint32_t	reserved[5];
+}				index_header_t;
+
+/**
+ * Digests collected while building an index.
+ */
+typedef struct	index_builder_s
+{
+	uint8_t		*digests;
+	size_t		count;
+	size_t		capacity;
+	size_t		digest_size;
+	size_t		bad_lines;
+}				index_builder_t;
+
+/**
+ * Reads the first 8 bytes of a digest as a big-endian integer.
+ * Sorting digests bytewise sorts these keys too, and since digests are
+ * uniformly distributed the keys are suited to interpolation search.
+ *
+ * @param digest The digest.
+ * @return The 64-bit key of the digest.
+ */
+static uint64_t	digest_key(const uint8_t *digest)
+{
+	uint64_t	key = 0;
+
+	for (int i = 0; i < 8; i++)
+		key = (key << 8) | digest[i];
+	return (key);
+}
+
+/**
+ * Derives the two Bloom filter hashes of a digest from its own bytes.
+ * Digests are already uniform, so no extra hashing is needed.
+ *
+ * @param digest The digest (at least 16 bytes).
+ * @param h1 Pointer receiving the first hash.
+ * @param h2 Pointer receiving the second (odd) hash.
+ */
+static void	bloom_hashes(const uint8_t *digest, uint64_t *h1, uint64_t *h2)
+{
+	memcpy(h1, digest, 8);
+	memcpy(h2, digest + 8, 8);
+	*h2 |= 1;
+}
+
+/**
+ * Checks whether a digest may be present in the index.
+ * The k probe positions are computed with double hashing and combined without
+ * early exit, so the test runs without data-dependent branches.
+ *
+ * @param index The index.
+ * @param digest The digest to test.
+ * @return Non-zero if the digest may be in the index, 0 if it is not.
+ */
+static int	bloom_test(const digest_index_t *index, const uint8_t *digest)
+{
+	uint64_t	h1;
+	uint64_t	h2;
+	uint64_t	mask = index->header->bloom_bits - 1;
+	uint64_t	found = 1;
+
+	bloom_hashes(digest, &h1, &h2);
+	for (uint32_t i = 0; i < index->header->bloom_hashes; i++)
+	{
+		uint64_t	bit = (h1 + i * h2) & mask;
+		found &= index->bloom[bit >> 6] >> (bit & 63);
+	}
+	return ((int)(found & 1));
+}
+
+/**
+ * Searches the sorted digests of an index.
+ * Interpolation on the 64-bit keys narrows the range in a few steps, then
+ * the remaining candidates are compared in full.
+ *
+ * @param index The index.
+ * @param digest The digest to look for.
+ * @return 1 if the digest is in the index, 0 otherwise.
+ */
+static int	index_search(const digest_index_t *index, const uint8_t *digest)
+{
+	size_t		size = index->header->digest_size;
+	uint64_t	key = digest_key(digest);
+	size_t		lo = 0;
+	size_t		hi = index->header->count;
+
+	if (hi == 0)
+		return (0);
+	hi--;
+	while (hi - lo > INDEX_SCAN_LIMIT)
+	{
+		uint64_t	key_lo = digest_key(index->digests + lo * size);
+		uint64_t	key_hi = digest_key(index->digests + hi * size);
+		if (key < key_lo || key > key_hi)
+			return (0);
+		if (key_hi == key_lo)
+			break;
+		size_t	pos = lo + (size_t)(((unsigned __int128)(key - key_lo) * (hi - lo)) / (key_hi - key_lo));
+		uint64_t	key_pos = digest_key(index->digests + pos * size);
+		if (key_pos < key)
+			lo = pos + 1;
+		else if (key_pos > key)
+			hi = pos - 1;
+		else
+		{
+			lo = pos;
+			hi = pos;
+			break;
+		}
+	}
+	while (lo > 0 && digest_key(index->digests + (lo - 1) * size) == key)
+		lo--;
+	while (hi + 1 < index->header->count && digest_key(index->digests + (hi + 1) * size) == key)
+		hi++;
+	for (size_t i = lo; i <= hi; i++)
+	{
+		if (memcmp(index->digests + i * size, digest, size) == 0)
+			return (1);
+	}
+	return (0);
+}
+
+/**
+ * Checks whether a digest is listed in an index.
+ *
+ * @param index The index.
+ * @param digest The digest to look for, of the index digest size.
+ * @return 1 if the digest is in the index, 0 otherwise.
+ */
+int	index_contains(const digest_index_t *index, const uint8_t *digest)
+{
+	return (bloom_test(index, digest) && index_search(index, digest));
+}
+
+/**
+ * Maps an index file in memory and validates its header.
+ *
+ * @param args The request the index is opened for (error messages).
+ * @param path The path of the index file.
+ * @param index Pointer to the structure receiving the mapping.
+ * @return 0 on success, 1 on error (an error message has been printed).
+ */
+int	index_open(const args_t *args, const char *path, digest_index_t *index)
+{
+	struct stat	st;
+	int			fd = open(path, O_RDONLY);
+
+	if (fd == -1 || fstat(fd, &st) == -1)
+	{
+		print_error(args, (char *)path, strerror(errno));
+		if (fd != -1)
+			close(fd);
+		return (1);
+	}
+	index->size = st.st_size;
+	index->map = (index->size >= sizeof(index_header_t))
+		? mmap(NULL, index->size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (index->map == MAP_FAILED)
+	{
+		print_error(args, (char *)path, "Not a digest index");
+		return (1);
+	}
+	index->header = (const index_header_t *)index->map;
+	index->bloom = (const uint64_t *)(index->map + sizeof(index_header_t));
+	index->digests = index->map + sizeof(index_header_t) + index->header->bloom_bits / 8;
+	if (memcmp(index->header->magic, INDEX_MAGIC, 8) != 0
+		|| index->header->version != INDEX_VERSION
+		|| index->header->bloom_bits < 64
+		|| (index->header->bloom_bits & (index->header->bloom_bits - 1))
+		|| index->header->digest_size < 16 || index->header->digest_size > MAX_DIGEST_SIZE
+		|| index->size != sizeof(index_header_t) + index->header->bloom_bits / 8
+			+ index->header->count * index->header->digest_size)
+	{
+		print_error(args, (char *)path, "Not a digest index");
+		munmap((void *)index->map, index->size);
+		return (1);
+	}
+	madvise((void *)index->map, index->size, MADV_RANDOM);
+	return (0);
+}
+
+/**
+ * Unmaps an index opened with index_open().
+ *
+ * @param index The index to release.
+ */
+void	index_close(digest_index_t *index)
+{
+	munmap((void *)index->map, index->size);
+}
+
+/**
+ * Loads the index given with --index into the request, for its algorithm.
+ *
+ * @param args The request.
+ * @return 0 on success, 1 if the index cannot be used (an error message has been printed).
+ */
+int	index_load_filter(args_t *args)
+{
+	if (index_open(args, args->index_file, &args->filter))
+		return (1);
+	if (args->filter.header->digest_size != get_algo(args->command)->digest_size)
+	{
+		print_request_error(args, "the index was not built for this algorithm.");
+		index_close(&args->filter);
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * Checks a computed digest against the index loaded with --index.
+ *
+ * @param args The request holding the index.
+ * @param digest The digest to look for.
+ * @return 1 if the digest is known, 0 otherwise.
+ */
+int	index_filter_match(const args_t *args, const uint8_t *digest)
+{
+	return (index_contains(&args->filter, digest));
+}
+
+/**
+ * Parses the digest at the start of an input line.
+ * The line may carry anything after the digest, as in the output of ft_ssl -r
+ * or of GNU md5sum/sha256sum.
+ *
+ * @param line The line.
+ * @param len The length of the line.
+ * @param size The expected digest size in bytes.
+ * @param digest Buffer receiving the digest.
+ * @return 1 if the line starts with a digest, 0 otherwise.
+ */
+static int	parse_digest_line(const char *line, size_t len, size_t size, uint8_t *digest)
+{
+	if (len < size * 2 || (len > size * 2 && !ft_strchr(" \t\r*", line[size * 2])))
+		return (0);
+	return (hex_string_to_bytes(line, size, digest));
+}
+
+/**
+ * Record callback appending the digest of a line to the index being built.
+ *
+ * @param line The line.
+ * @param len The length of the line.
+ * @param data Pointer to the index_builder_t.
+ */
+static void	collect_digest(const char *line, size_t len, void *data)
+{
+	index_builder_t	*builder = data;
+
+	if (len == 0)
+		return;
+	if (builder->count == builder->capacity)
+	{
+		size_t	capacity = builder->capacity ? builder->capacity * 2 : 65536;
+		uint8_t	*digests = realloc(builder->digests, capacity * builder->digest_size);
+		if (!digests)
+			print_error_and_exit("malloc() failed");
+		builder->digests = digests;
+		builder->capacity = capacity;
+	}
+	if (parse_digest_line(line, len, builder->digest_size,
+		builder->digests + builder->count * builder->digest_size))
+		builder->count++;
+	else
+		builder->bad_lines++;
+}
+
+static size_t	sort_digest_size;
+
+/**
+ * qsort() comparator ordering digests bytewise.
+ */
+static int	compare_digests(const void *a, const void *b)
+{
+	return (memcmp(a, b, sort_digest_size));
+}
+
+/**
+ * Sorts the collected digests and drops the duplicates.
+ *
+ * @param builder The index being built.
+ */
+static void	sort_unique(index_builder_t *builder)
+{
+	size_t	size = builder->digest_size;
+	size_t	kept = 0;
+
+	sort_digest_size = size;
+	qsort(builder->digests, builder->count, size, compare_digests);
+	for (size_t i = 0; i < builder->count; i++)
+	{
+		if (kept && memcmp(builder->digests + (kept - 1) * size, builder->digests + i * size, size) == 0)
+			continue;
+		if (kept != i)
+			memcpy(builder->digests + kept * size, builder->digests + i * size, size);
+		kept++;
+	}
+	builder->count = kept;
+}
+
+/**
+ * Writes the index file: header, Bloom filter, then sorted digests.
+ * The filter uses about INDEX_BLOOM_BITS bits per digest, rounded up to a
+ * power of two, and INDEX_BLOOM_HASHES probes.
+ *
+ * @param args The request (error messages).
+ * @param path The path of the index file to create.
+ * @param builder The sorted digests.
+ * @return 0 on success, 1 on error.
+ */
+static int	write_index(const args_t *args, const char *path, index_builder_t *builder)
+{
+	index_header_t	header;
+	uint64_t		*bloom;
+	FILE			*out;
+
+	ft_bzero(&header, sizeof(header));
+	memcpy(header.magic, INDEX_MAGIC, 8);
+	header.version = INDEX_VERSION;
+	header.digest_size = builder->digest_size;
+	header.count = builder->count;
+	header.bloom_bits = 64;
+	while (header.bloom_bits < builder->count * INDEX_BLOOM_BITS)
+		header.bloom_bits <<= 1;
+	header.bloom_hashes = INDEX_BLOOM_HASHES;
+	if (!(bloom = ft_calloc(header.bloom_bits / 64, sizeof(uint64_t))))
+		return (1);
+	for (size_t i = 0; i < builder->count; i++)
+	{
+		uint64_t	h1;
+		uint64_t	h2;
+		bloom_hashes(builder->digests + i * builder->digest_size, &h1, &h2);
+		for (uint32_t k = 0; k < header.bloom_hashes; k++)
+		{
+			uint64_t	bit = (h1 + k * h2) & (header.bloom_bits - 1);
+			bloom[bit >> 6] |= (uint64_t)1 << (bit & 63);
+		}
+	}
+	if (!(out = fopen(path, "wb")))
+	{
+		print_error(args, (char *)path, strerror(errno));
+		free(bloom);
+		return (1);
+	}
+	int	error = fwrite(&header, sizeof(header), 1, out) != 1
+		|| fwrite(bloom, header.bloom_bits / 8, 1, out) != 1
+		|| (builder->count && fwrite(builder->digests, builder->digest_size, builder->count, out) != builder->count);
+	error |= (fclose(out) != 0);
+	if (error)
+		print_error(args, (char *)path, strerror(errno));
+	free(bloom);
+	return (error);
+}
+
+/**
+ * Builds an index from lists of hexadecimal digests.
+ * Usage: ft_ssl index build [-a algo] -o INDEX [file...]
+ *
+ * @param args The request, receiving the algorithm.
+ * @param ac The argument count.
+ * @param av The argument vector, av[2] being "build".
+ * @return 0 on success, 1 on error.
+ */
+static int	index_build(args_t *args, int ac, char **av)
+{
+	index_builder_t	builder = {NULL, 0, 0, 0, 0};
+	char			*output = NULL;
+	int				i = 3;
+	int				error = 0;
+
+	while (i < ac && av[i][0] == '-' && av[i][1])
+	{
+		if (strcmp(av[i], "-a") == 0 && i + 1 < ac && (args->command = find_algo(av[i + 1])))
+			i++;
+		else if (strcmp(av[i], "-o") == 0 && i + 1 < ac)
+			output = av[++i];
+		else
+		{
+			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid flag.\n", av[i]);
+			return (1);
+		}
+		i++;
+	}
+	if (!output)
+		print_error_and_exit("usage: ft_ssl index build [-a md5|sha256|whirlpool] -o INDEX [file...]");
+	builder.digest_size = get_algo(args->command)->digest_size;
+	if (i == ac)
+		error |= read_records(args, "-", '\n', collect_digest, &builder);
+	for (; i < ac; i++)
+		error |= read_records(args, av[i], '\n', collect_digest, &builder);
+	if (builder.bad_lines)
+		fprintf(stderr, "ft_ssl: WARNING: %zu line%s without a valid %s digest ignored\n",
+			builder.bad_lines, builder.bad_lines > 1 ? "s" : "", get_algo(args->command)->label);
+	sort_unique(&builder);
+	error |= write_index(args, output, &builder);
+	free(builder.digests);
+	return (error);
+}
+
+/**
+ * Record callback printing the lines whose digest is in the index.
+ *
+ * @param line The line.
+ * @param len The length of the line.
+ * @param data Pointer to the index.
+ */
+static void	lookup_line(const char *line, size_t len, void *data)
+{
+	digest_index_t	*index = data;
+	uint8_t			digest[MAX_DIGEST_SIZE];
+
+	if (parse_digest_line(line, len, index->header->digest_size, digest)
+		&& index_contains(index, digest))
+	{
+		char	*out = output_reserve(STDOUT_FILENO, len + 1);
+
+		memcpy(out, line, len);
+		out[len] = '\n';
+		output_commit(len + 1);
+		index->matches++;
+	}
+}
+
+/**
+ * Prints the input lines whose leading digest is listed in an index.
+ * Usage: ft_ssl index lookup INDEX [file...]
+ *
+ * @param args The request.
+ * @param ac The argument count.
+ * @param av The argument vector, av[2] being "lookup".
+ * @return 0 if at least one digest was found, 1 otherwise.
+ */
+static int	index_lookup(const args_t *args, int ac, char **av)
+{
+	digest_index_t	index;
+
+	if (ac < 4)
+		print_error_and_exit("usage: ft_ssl index lookup INDEX [file...]");
+	if (index_open(args, av[3], &index))
+		return (1);
+	index.matches = 0;
+	if (ac == 4)
+		read_records(args, "-", '\n', lookup_line, &index);
+	for (int i = 4; i < ac; i++)
+		read_records(args, av[i], '\n', lookup_line, &index);
+	index_close(&index);
+	return (index.matches == 0);
+}
+
+/**
+ * Entry point of the index command.
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "index".
+ * @return The exit status of the sub-command.
+ */
+int	index_command(int ac, char **av)
+{
+	args_t	args;
+
+	args_init(&args);
+	args.command = 2;
+	if (ac >= 3 && strcmp(av[2], "build") == 0)
+		return (index_build(&args, ac, av));
+	if (ac >= 3 && strcmp(av[2], "lookup") == 0)
+		return (index_lookup(&args, ac, av));
+	print_error_and_exit("usage: ft_ssl index build|lookup ...");
+	return (1);
+}
@@ -1,7 +1,5 @@
 #include "../includes/ft_ssl.h"
 
-extern args_t	args;
-
 /**
  * Frees allocated memory and exits if necessary.
  * This function is used to free the memory allocated for the line and args_cli,
@@ -45,52 +43,67 @@ static int	count_args_and_remove_return(char **args_cli)
 }
 
 /**
- * Checks if the given algorithm is authorized.
- * This function compares the provided algorithm name with the allowed
- * algorithm names (md5, sha256, whirlpool) and returns a status.
+ * Checks an "execute" line of the command path shared by interactive mode,
+ * --script and serve, and fills its request.
+ * Errors are reported through the request, so that they land in its capture
+ * buffer when it has one and stay in order with the results.
  *
- * @param algo Pointer to the string representing the algorithm name.
- * @return 1 if the algorithm is authorized, 0 otherwise.
+ * @param args The request, initialized with args_init().
+ * @param tokens The words of the line, NULL-terminated, tokens[0] being the command.
+ * @param count The number of words.
+ * @param mode The name of the mode, for the "no input" error.
+ * @return 0 if the command can run, 1 otherwise.
  */
-static int	check_autorised_algo(char *algo)
+int	execute_prepare(args_t *args, char **tokens, int count, const char *mode)
 {
-	if (ft_strlen(algo) == 3 && ft_strncmp(algo, "md5", 3) == 0)
+	char	message[256];
+
+	if (strcmp(tokens[0], "execute") != 0)
+	{
+		snprintf(message, sizeof(message), "'%s' is an invalid command (use execute or exit).", tokens[0]);
+		print_request_error(args, message);
+		return (1);
+	}
+	if (count < 2)
+	{
+		print_request_error(args, "no algorithm specified.");
+		return (1);
+	}
+	if (!find_algo(tokens[1]))
+	{
+		snprintf(message, sizeof(message), "'%s' is an invalid algorithm (use md5, sha256 or whirlpool).", tokens[1]);
+		print_request_error(args, message);
 		return (1);
-	else if (ft_strlen(algo) == 6 && ft_strncmp(algo, "sha256", 6) == 0)
+	}
+	if (parse_args(args, count, tokens))
 		return (1);
-	else if (ft_strlen(algo) == 9 && ft_strncmp(algo, "whirlpool", 9) == 0)
+	if (args->num_strings == 0 && args->num_files == 0)
+	{
+		snprintf(message, sizeof(message), "no input specified. In %s mode you must specify a file or a string.", mode);
+		print_request_error(args, message);
 		return (1);
+	}
 	return (0);
 }
 
 /**
- * Handles the execution of the 'execute' command.
- * This function checks if the specified algorithm is authorized and processes the command
- * arguments. It calls ft_hash to perform hashing if valid input is provided.
+ * Tells whether a request uses the worker pool itself, reads stdin or
+ * streams its output, so that it cannot run as a job of the pool.
  *
- * @param args_cli Array of command-line arguments.
- * @param nb_args Number of arguments in args_cli.
+ * @param args The request.
+ * @return 1 if the request must run alone, 0 otherwise.
  */
-static void	handle_execute_command(char **args_cli, int nb_args)
+int	execute_runs_alone(const args_t *args)
 {
-	if (!check_autorised_algo(args_cli[1]))
-	{
-		ft_printf("ft_ssl: Error: '%s' is an invalid algorithm (use md5, sha256 or whirlpool).\n", args_cli[1]);
-		return;
-	}
-
-	parse_args(nb_args, args_cli);
-	if (args.num_strings == 0 && args.num_files == 0)
-		ft_printf("ft_ssl: Error: no input specified. In interactive mode you must specify a file or a string.\n");
-	else
-		ft_hash();
+	return (args->recursive || args->files_from || args->disk_order || args->check_file
+		|| args->per_line || args->tar || args->batch || args->echo);
 }
 
 /**
  * Processes a single command line input.
  * This function splits the input line into arguments, counts them, and determines
- * the appropriate action based on the command (exit, execute, etc.). It handles
- * the execution of commands and the printing of relevant error messages.
+ * the appropriate action based on the command (exit, execute, etc.).
+ * Each line gets a fresh request, so nothing leaks from one command to the next.
  *
  * @param line The command line input to be processed.
  */
@@ -98,19 +111,13 @@ static void	process_command(char *line)
 {
 	char	**args_cli = ft_split(line, ' ');
 	int		nb_args = count_args_and_remove_return(args_cli);
+	args_t	args;
 
-	if (ft_strncmp(args_cli[0], "exit", 5) == 0)
+	if (nb_args && ft_strncmp(args_cli[0], "exit", 5) == 0)
 		free_interactive(line, args_cli, 1);
-	else if (ft_strncmp(args_cli[0], "execute", 8) == 0)
-	{
-		if (nb_args > 1)
-			handle_execute_command(args_cli, nb_args);
-		else
-			ft_printf("ft_ssl: Error: no algorithm specified.\n");
-	}
-	else
-		ft_printf("ft_ssl: Error: '%s' is an invalid command (use execute or exit).\n", args_cli[0]);
-
+	args_init(&args);
+	if (nb_args && !execute_prepare(&args, args_cli, nb_args, "interactive"))
+		ft_hash(&args);
 	free_interactive(line, args_cli, 0);
 }
 
@@ -127,6 +134,7 @@ void	ft_command_line(void)
 	ft_printf("Commands: exit, execute\n");
 	while (1)
 	{
+		output_flush();
 		ft_printf("ft_ssl> ");
 		line = get_next_line(0);
 		if (!line)
@@ -0,0 +1,147 @@
+#include "../includes/ft_ssl.h"
+#include "../includes/libftssl.h"
+
+_Static_assert(sizeof(hash_ctx_t) <= FTSSL_CTX_SIZE, "FTSSL_CTX_SIZE is too small");
+_Static_assert(MAX_DIGEST_SIZE == FTSSL_MAX_DIGEST_SIZE, "digest sizes differ");
+
+/**
+ * Returns the algorithm of a name ("md5", "sha256" or "whirlpool").
+ *
+ * @param name The name of the algorithm.
+ * @return The algorithm, or 0 if the name is unknown.
+ */
+ftssl_algo_t	ftssl_algo_by_name(const char *name)
+{
+	return ((ftssl_algo_t)find_algo(name));
+}
+
+/**
+ * Returns the size of the digests of an algorithm.
+ *
+ * @param algo The algorithm.
+ * @return The size in bytes, or 0 if the algorithm is unknown.
+ */
+size_t	ftssl_digest_size(ftssl_algo_t algo)
+{
+	const hash_algo_t	*hash = get_algo(algo);
+
+	return (hash ? hash->digest_size : 0);
+}
+
+/**
+ * Starts a streaming computation.
+ *
+ * @param ctx The context, owned by the caller.
+ * @param algo The algorithm.
+ * @return 0 on success, -1 if the algorithm is unknown.
+ */
+int	ftssl_init(ftssl_ctx_t *ctx, ftssl_algo_t algo)
+{
+	const hash_algo_t	*hash = get_algo(algo);
+
+	if (!hash)
+		return (-1);
+	ctx->algo = algo;
+	hash->init((hash_ctx_t *)&ctx->state);
+	return (0);
+}
+
+/**
+ * Feeds bytes to a streaming computation.
+ *
+ * @param ctx The context, started with ftssl_init().
+ * @param data The bytes.
+ * @param len The number of bytes.
+ */
+void	ftssl_update(ftssl_ctx_t *ctx, const void *data, size_t len)
+{
+	get_algo(ctx->algo)->update((hash_ctx_t *)&ctx->state, data, len);
+}
+
+/**
+ * Ends a streaming computation and writes its digest.
+ * The context must be started again before being reused.
+ *
+ * @param ctx The context, started with ftssl_init().
+ * @param digest Buffer of ftssl_digest_size() bytes receiving the digest.
+ */
+void	ftssl_final(ftssl_ctx_t *ctx, uint8_t *digest)
+{
+	get_algo(ctx->algo)->final((hash_ctx_t *)&ctx->state, digest);
+}
+
+/**
+ * Computes the digest of a message in one call, taking the single-block
+ * fast path for short messages.
+ *
+ * @param algo The algorithm.
+ * @param data The message.
+ * @param len The length of the message.
+ * @param digest Buffer of ftssl_digest_size() bytes receiving the digest.
+ * @return 0 on success, -1 if the algorithm is unknown.
+ */
+int	ftssl_digest(ftssl_algo_t algo, const void *data, size_t len, uint8_t *digest)
+{
+	const hash_algo_t	*hash = get_algo(algo);
+
+	if (!hash)
+		return (-1);
+	hash->digest(data, len, digest);
+	return (0);
+}
+
+/**
+ * Computes the digests of many messages. Short messages are hashed
+ * MB_LANES at a time by the multi-lane kernels.
+ *
+ * @param algo The algorithm.
+ * @param messages The messages.
+ * @param lens The lengths of the messages.
+ * @param digests The buffers receiving the digests, one per message.
+ * @param count The number of messages.
+ * @return 0 on success, -1 if the algorithm is unknown.
+ */
+int	ftssl_digest_batch(ftssl_algo_t algo, const uint8_t *const *messages,
+	const size_t *lens, uint8_t *const *digests, size_t count)
+{
+	const hash_algo_t	*hash = get_algo(algo);
+
+	if (!hash)
+		return (-1);
+	digest_batch(hash, (const uint8_t **)messages, lens, (uint8_t **)digests, count);
+	return (0);
+}
+
+/**
+ * Encodes bytes as lowercase hexadecimal, without a terminating NUL.
+ *
+ * @param bytes The bytes.
+ * @param len The number of bytes.
+ * @param out The buffer receiving 2 * len characters.
+ */
+void	ftssl_hex(const uint8_t *bytes, size_t len, char *out)
+{
+	hex_encode(bytes, len, out);
+}
+
+/**
+ * Returns the name of the compression kernels in use.
+ *
+ * @return "scalar", "sse2" or "shani".
+ */
+const char	*ftssl_impl(void)
+{
+	return (hash_impl->name);
+}
+
+/**
+ * Forces the compression kernels, or restores the automatic choice.
+ * Not thread-safe: call it before hashing from several threads.
+ *
+ * @param name The name of a kernel set, or "auto".
+ * @return 0 on success, -1 if the set is unknown or the CPU lacks it.
+ */
+int	ftssl_set_impl(const char *name)
+{
+	return (impl_select(name) ? -1 : 0);
+}
@@ -1,77 +1,308 @@
 #include "../includes/ft_ssl.h"
 
-args_t	args = {0, 0, 0, 0, {}, 0, {}, 0};
+/**
+ * Displays a raw digest.
+ * With --index, only the digests listed in the index are displayed.
+ * With --binary, the digest bytes are written alone; otherwise the digest is
+ * encoded on the stack and displayed in a line.
+ *
+ * @param args The request the digest belongs to.
+ * @param digest The raw digest.
+ * @param name The name displayed for the message (string, file name or stdin content).
+ * @param type Indicator of the input source type: 1 for stdin, 2 for string, 3 for file.
+ */
+void	display_digest(const args_t *args, const uint8_t *digest, char *name, int type)
+{
+	if (args->index_file && !index_filter_match(args, digest))
+		return;
+
+	size_t	size = get_algo(args->command)->digest_size;
+	char	text[MAX_DIGEST_SIZE * 2 + 1];
+
+	if (args->encoding == ENCODING_BINARY)
+	{
+		memcpy(display_reserve(args, size), digest, size);
+		display_commit(args, size);
+		return;
+	}
+	text[display_encode(args, digest, size, text)] = '\0';
+	display_hash(args, text, name, type);
+}
+
+/**
+ * Hashes a message and displays its digest.
+ * With --prefix-file, the message is hashed after the prefix.
+ *
+ * @param args The request.
+ * @param msg Pointer to the message to hash.
+ * @param size Length of the message in bytes.
+ * @param name The name displayed for the message (string, file name or stdin content).
+ * @param type Indicator of the input source type: 1 for stdin, 2 for string, 3 for file.
+ */
+static void	hash_message(const args_t *args, uint8_t *msg, size_t size, char *name, int type)
+{
+	const hash_algo_t	*algo = get_algo(args->command);
+	uint8_t				digest[MAX_DIGEST_SIZE];
+
+	if (args->prefix_file)
+		midstate_digest(algo, &args->midstate, msg, size, digest);
+	else
+		algo->digest(msg, size, digest);
+	display_digest(args, digest, name, type);
+}
+
+/**
+ * Hashes the strings given with -s and displays their digests in order.
+ * The strings are hashed as one batch, so that short ones share the
+ * multi-lane kernels.
+ *
+ * @param args The request.
+ */
+static void	hash_strings(const args_t *args)
+{
+	const uint8_t	*msgs[MAX_STRINGS];
+	size_t			lens[MAX_STRINGS];
+	uint8_t			digests[MAX_STRINGS][MAX_DIGEST_SIZE];
+	uint8_t			*outputs[MAX_STRINGS];
+	size_t			count = 0;
+
+	while (count < MAX_STRINGS && args->strings[count])
+	{
+		msgs[count] = (const uint8_t *)args->strings[count];
+		lens[count] = strlen(args->strings[count]);
+		outputs[count] = digests[count];
+		count++;
+	}
+	if (args->prefix_file)
+		midstate_digest_batch(get_algo(args->command), &args->midstate, msgs, lens, outputs, count);
+	else
+		digest_batch(get_algo(args->command), msgs, lens, outputs, count);
+	for (size_t i = 0; i < count; i++)
+		display_digest(args, digests[i], args->strings[i], 2);
+}
+
+/**
+ * Hashes a file and displays its digest.
+ * The file is streamed through the scratch arena of the calling thread, so
+ * nothing is allocated per file.
+ *
+ * @param args The request.
+ * @param path The path of the file to hash.
+ */
+static void	hash_file(const args_t *args, char *path)
+{
+	const hash_algo_t	*algo = get_algo(args->command);
+	uint8_t				digest[MAX_DIGEST_SIZE];
+	hash_ctx_t			ctx;
+
+	if (args->prefix_file)
+		ctx = args->midstate;
+	else
+		algo->init(&ctx);
+	if (hash_stream_file(args, path, algo, &ctx, NULL) == 0)
+	{
+		algo->final(&ctx, digest);
+		display_digest(args, digest, path, 3);
+	}
+}
+
+/**
+ * Hashes a single file and displays its digest.
+ * Runs on the hashing workers, so it releases the path it was given.
+ *
+ * @param path The path of the file to hash.
+ * @param data The request.
+ */
+static void	hash_file_job(char *path, void *data)
+{
+	hash_file(data, path);
+	free(path);
+}
+
+/**
+ * Walker callback streaming each discovered file to the hashing workers.
+ *
+ * @param file The file found by the walker.
+ * @param data The request.
+ */
+static void	submit_file(walk_entry_t *file, void *data)
+{
+	engine_submit(hash_file_job, file->path, data);
+}
+
+/**
+ * Compresses the content of the --prefix-file once, for every message to be
+ * hashed after it.
+ *
+ * @param args The request.
+ * @return 0 on success, 1 if the prefix file cannot be read.
+ */
+static int	load_prefix(args_t *args)
+{
+	size_t	size = 0;
+	uint8_t	*prefix = read_binary_file(args, args->prefix_file, &size);
+
+	if (!prefix)
+		return (1);
+	midstate_init(get_algo(args->command), prefix, size, &args->midstate);
+	free(prefix);
+	return (0);
+}
 
 /**
  * Processes hashing for the given arguments.
  * This function reads data from stdin, files, or strings as specified in the arguments,
  * computes their hashes using the selected hash function, and displays the results.
  * It handles file and string inputs, as well as direct stdin data.
+ * In check mode (-c), the manifest is verified instead.
+ *
+ * @param args The request.
+ * @return 0 on success, 1 if a checksum verification failed.
  */
-void	ft_hash(void)
+static int	hash_inputs(const args_t *args)
 {
-	int				i = 0;
-	size_t			size = 0;
-	uint8_t			*file_content;
-	hash_function_t	hash_function;
+	int		i = 0;
+	size_t	size = 0;
+	uint8_t	*file_content;
 
-	switch (args.command)
-	{
-		case 1: hash_function = my_MD5; break;
-		case 2: hash_function = my_SHA256; break;
-		case 3: hash_function = my_WHIRLPOOL; break;
-	}
-	if (args.echo || (!args.num_strings && !args.num_files))
+	if (args->check_file)
+		return (check_manifest(args));
+	if (args->batch)
+		return (hash_batch(args));
+
+	if (args->echo || (!args->num_strings && !args->num_files && !args->files_from && !args->per_line && !args->tar))
 	{
-		file_content = read_binary_file(NULL, &size);
+		file_content = read_binary_file(args, NULL, &size);
 		if (file_content)
-		{
-			char	*representation = hash_function(file_content, size);
-			display_hash(representation, (char *)file_content, 1);
-			free(representation);
-		}
+			hash_message(args, file_content, size, (char *)file_content, 1);
 	}
 
-	while (args.strings[i])
+	hash_strings(args);
+
+	if (args->per_line || args->tar)
 	{
-		char *representation = hash_function((uint8_t *)args.strings[i], strlen(args.strings[i]));
-		display_hash(representation, args.strings[i], 2);
-		free(representation);
-		i++;
+		int	(*hash_stream)(const args_t *, const char *) = args->tar ? hash_tar : hash_lines;
+		int	ret = 0;
+
+		for (i = 0; args->files[i]; i++)
+			ret |= hash_stream(args, args->files[i]);
+		if (!args->num_strings && !args->num_files)
+			ret |= hash_stream(args, "-");
+		return (ret);
 	}
 
-	i = 0;
-	while (args.files[i])
+	if (args->recursive || args->files_from || args->disk_order)
 	{
-		file_content = read_binary_file(args.files[i], &size);
-		if (file_content)
+		engine_start(args->disk_order ? ENGINE_DISK_ORDER : 0);
+		if (args->recursive)
+			walk_tree(args, (char **)args->files, args->num_files, 0, submit_file, (void *)args);
+		else
 		{
-			char *representation = hash_function(file_content, size);
-			display_hash(representation, args.files[i], 3);
-			free(representation);
+			for (i = 0; args->files[i]; i++)
+			{
+				char	*path = strdup(args->files[i]);
+				if (path)
+					engine_submit(hash_file_job, path, (void *)args);
+			}
 		}
-		free(file_content);
-		i++;
+		if (args->files_from)
+			read_file_list(args, args->files_from, args->null_data ? '\0' : '\n', hash_file_job, (void *)args);
+		engine_finish();
+		return (0);
 	}
+
+	for (i = 0; args->files[i]; i++)
+		hash_file(args, args->files[i]);
+	return (0);
+}
+
+/**
+ * Runs a hashing request: loads its --index filter and --prefix-file state,
+ * hashes its inputs and writes their buffered output, then releases what was
+ * loaded, so that the request can be dropped once done.
+ *
+ * @param args The request, filled by parse_args().
+ * @return 0 on success, 1 if a checksum verification failed.
+ */
+int	ft_hash(args_t *args)
+{
+	int	filter = args->index_file && !args->check_file;
+	int	ret;
+
+	if (filter && index_load_filter(args))
+		return (1);
+	if (args->prefix_file && !args->check_file && load_prefix(args))
+		ret = 1;
+	else
+		ret = hash_inputs(args);
+	if (filter)
+		index_close(&args->filter);
+	output_flush();
+	return (ret);
 }
 
 /**
  * The main function of the ft_ssl program.
  * This function initializes the program, processes command line arguments if provided,
  * and invokes the appropriate functions to handle hashing or command line interaction.
+ * The FT_SSL_IMPL environment variable, then a leading "--impl NAME", force
+ * the compression kernels for the rest of the command.
  *
  * @param ac Argument count.
  * @param av Argument vector (array of strings).
- * @return Returns 0 upon successful execution.
+ * @return Returns 0 upon successful execution, 1 if a checksum verification failed.
  */
 int	main(int ac, char **av)
 {
+	const char	*impl = getenv("FT_SSL_IMPL");
+
+	if (impl && *impl && impl_select(impl) != 0)
+		fprintf(stderr, "ft_ssl: warning: FT_SSL_IMPL='%s' is not available, using auto.\n", impl);
+	if (ac > 1 && strcmp(av[1], "--impl") == 0)
+	{
+		int	ret = ac > 2 ? impl_select(av[2]) : 1;
+
+		if (ret == 1)
+			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid implementation (use auto, scalar, sse2 or shani).\n",
+				ac > 2 ? av[2] : "");
+		else if (ret == 2)
+			fprintf(stderr, "ft_ssl: Error: '%s' is not supported by this CPU.\n", av[2]);
+		if (ret)
+			return (1);
+		av[2] = av[0];
+		av += 2;
+		ac -= 2;
+	}
 	if (ac == 1)
 		ft_command_line();
+	else if (strcmp(av[1], "dedup") == 0)
+		return (dedup_command(ac, av));
+	else if (strcmp(av[1], "store") == 0)
+		return (store_command(ac, av));
+	else if (strcmp(av[1], "index") == 0)
+		return (index_command(ac, av));
+	else if (strcmp(av[1], "crack") == 0)
+		return (crack_command(ac, av));
+	else if (strcmp(av[1], "hmac") == 0)
+		return (hmac_command(ac, av));
+	else if (strcmp(av[1], "pbkdf2") == 0)
+		return (pbkdf2_command(ac, av));
+	else if (strcmp(av[1], "serve") == 0)
+		return (serve_command(ac, av));
+	else if (strcmp(av[1], "pow") == 0)
+		return (pow_command(ac, av));
+	else if (strcmp(av[1], "bench") == 0)
+		return (bench_command(ac, av));
+	else if (strcmp(av[1], "--script") == 0)
+		return (script_command(ac, av));
 	else
 	{
-		parse_args(ac, av);
-		ft_hash();
+		args_t	args;
+
+		args_init(&args);
+		if (parse_args(&args, ac, av))
+			return (1);
+		return (ft_hash(&args));
 	}
 
 	return (0);
@@ -0,0 +1,206 @@
+#include "../includes/ft_ssl.h"
+#include <sys/uio.h>
+
+/**
+ * Buffered output of a thread.
+ * Each thread formats its lines into its own buffer, without locking, and
+ * hands whole buffers to the kernel. Lines are only appended whole, so the
+ * output of several threads never interleaves inside a line.
+ */
+typedef struct	output_sink_s
+{
+	int		fd;
+	size_t	len;
+	size_t	capacity;
+	char	*data;
+}				output_sink_t;
+
+static pthread_key_t	sink_key;
+static pthread_once_t	sink_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Writes a whole iovec array, resuming after partial writes.
+ *
+ * @param fd The descriptor to write to.
+ * @param iov The buffers to write, modified by this function.
+ * @param count The number of buffers.
+ */
+static void	write_iov(int fd, struct iovec *iov, int count)
+{
+	while (count > 0)
+	{
+		ssize_t	written = writev(fd, iov, count);
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			perror("ft_ssl: writev() failed");
+			return;
+		}
+		while (count > 0 && (size_t)written >= iov->iov_len)
+		{
+			written -= iov->iov_len;
+			iov++;
+			count--;
+		}
+		if (count > 0)
+		{
+			iov->iov_base = (char *)iov->iov_base + written;
+			iov->iov_len -= written;
+		}
+	}
+}
+
+/**
+ * Releases the buffer of an exiting thread, writing what it still holds,
+ * so that the output of a worker is out by the time it is joined.
+ *
+ * @param data The sink of the thread.
+ */
+static void	sink_release(void *data)
+{
+	output_sink_t	*sink = data;
+	struct iovec	iov = {sink->data, sink->len};
+
+	write_iov(sink->fd, &iov, sink->len ? 1 : 0);
+	free(sink->data);
+	free(sink);
+}
+
+/**
+ * Writes the buffer of the main thread when the program exits.
+ */
+static void	sink_exit(void)
+{
+	output_flush();
+}
+
+static void	sink_key_create(void)
+{
+	pthread_key_create(&sink_key, sink_release);
+	atexit(sink_exit);
+}
+
+/**
+ * Returns the sink of the calling thread, creating it on first use.
+ *
+ * @return The sink.
+ */
+static output_sink_t	*get_sink(void)
+{
+	output_sink_t	*sink;
+
+	pthread_once(&sink_once, sink_key_create);
+	if ((sink = pthread_getspecific(sink_key)))
+		return (sink);
+	if (!(sink = calloc(1, sizeof(output_sink_t)))
+		|| !(sink->data = malloc(OUTPUT_BUFFER_SIZE)))
+	{
+		perror("ft_ssl: malloc() failed");
+		exit(1);
+	}
+	sink->fd = STDOUT_FILENO;
+	sink->capacity = OUTPUT_BUFFER_SIZE;
+	pthread_setspecific(sink_key, sink);
+	return (sink);
+}
+
+/**
+ * Writes the buffered output of the calling thread.
+ * Called before handing over to other threads (engine_start()) and when a
+ * request is done, so that output keeps the order in which it was produced.
+ */
+void	output_flush(void)
+{
+	output_sink_t	*sink;
+	struct iovec	iov;
+
+	pthread_once(&sink_once, sink_key_create);
+	if (!(sink = pthread_getspecific(sink_key)) || sink->len == 0)
+		return;
+	iov.iov_base = sink->data;
+	iov.iov_len = sink->len;
+	sink->len = 0;
+	write_iov(sink->fd, &iov, 1);
+}
+
+/**
+ * Returns room for 'len' contiguous bytes at the end of the buffer of the
+ * calling thread, flushing it first if needed. The buffer only grows for a
+ * single line longer than OUTPUT_BUFFER_SIZE.
+ *
+ * @param fd The descriptor the bytes are meant for.
+ * @param len The number of bytes.
+ * @return Where to write the bytes, followed by a call to output_commit().
+ */
+char	*output_reserve(int fd, size_t len)
+{
+	output_sink_t	*sink = get_sink();
+
+	if (sink->fd != fd || sink->len + len > sink->capacity)
+	{
+		output_flush();
+		sink->fd = fd;
+	}
+	if (len > sink->capacity)
+	{
+		free(sink->data);
+		if (!(sink->data = malloc(len)))
+		{
+			perror("ft_ssl: malloc() failed");
+			exit(1);
+		}
+		sink->capacity = len;
+	}
+	return (sink->data + sink->len);
+}
+
+/**
+ * Appends the bytes written after output_reserve() to the buffer of the
+ * calling thread, writing the buffer once it is full.
+ *
+ * @param len The number of bytes written.
+ */
+void	output_commit(size_t len)
+{
+	output_sink_t	*sink = get_sink();
+
+	sink->len += len;
+	if (sink->len >= OUTPUT_BUFFER_SIZE)
+		output_flush();
+}
+
+/**
+ * Appends bytes to the buffer of the calling thread.
+ * Blocks larger than the buffer are not copied: they are written together
+ * with what is buffered by a single writev().
+ *
+ * @param fd The descriptor to write to.
+ * @param data The bytes.
+ * @param len The number of bytes.
+ */
+void	output_write(int fd, const void *data, size_t len)
+{
+	output_sink_t	*sink = get_sink();
+	struct iovec	iov[2];
+	int				count = 0;
+
+	if (len < OUTPUT_BUFFER_SIZE)
+	{
+		memcpy(output_reserve(fd, len), data, len);
+		output_commit(len);
+		return;
+	}
+	if (sink->fd != fd)
+		output_flush();
+	if (sink->len)
+	{
+		iov[count].iov_base = sink->data;
+		iov[count++].iov_len = sink->len;
+	}
+	iov[count].iov_base = (void *)data;
+	iov[count++].iov_len = len;
+	sink->len = 0;
+	write_iov(fd, iov, count);
+}
@@ -1,116 +1,228 @@
 #include "../includes/ft_ssl.h"
 
-extern args_t	args;
+/**
+ * Reports an invalid argument on the output of the request.
+ *
+ * @param args The request being parsed.
+ * @param str The error message.
+ * @return Always 1, the status of a failed parsing.
+ */
+static int	parse_error(const args_t *args, char *str)
+{
+	print_request_error(args, str);
+	return (1);
+}
 
 /**
  * Parses individual flag arguments for the command.
- * Validates the flag and sets the corresponding option in the global 'args' structure.
- * Supported flags are -p (echo), -q (quiet), and -r (reverse).
- * Exits the program if an invalid flag is encountered or if a flag is incorrectly formatted.
+ * Validates the flag and sets the corresponding option of the request.
+ * Supported flags are -p (echo), -q (quiet), -r (reverse), -R (recursive)
+ * and -0 (NUL-delimited --files-from list).
+ * Reports an invalid or incorrectly formatted flag on the output of the
+ * request, so that it stays in order with the results in --script and serve.
  *
+ * @param args The request being parsed.
  * @param arg The flag argument to parse.
+ * @return 0 on success, 1 if the flag is invalid.
  */
-static void	parse_flags(char *arg)
+static int	parse_flags(args_t *args, char *arg)
 {
+	char	message[256];
+
 	if (strlen(arg) != 2)
 	{
-		fprintf(stderr, "ft_ssl: Error: '%s' is an invalid flag.\n", arg);
-		exit(1);
+		snprintf(message, sizeof(message), "'%s' is an invalid flag.", arg);
+		return (parse_error(args, message));
 	}
 	switch (arg[1])
 	{
 		case 'p':
-			args.echo = 1;
+			args->echo = 1;
 			break;
 		case 'q':
-			args.quiet = 1;
+			args->quiet = 1;
 			break;
 		case 'r':
-			args.reverse = 1;
+			args->reverse = 1;
+			break;
+		case 'R':
+			args->recursive = 1;
+			break;
+		case '0':
+			args->null_data = 1;
 			break;
 		case 's':
-			fprintf(stderr, "ft_ssl: Error: '-s' expect a string after it.\n");
-			exit(1);
+			return (parse_error(args, "'-s' expect a string after it."));
 		default:
-			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid flag.\n", arg);
-			exit(1);
+			snprintf(message, sizeof(message), "'%s' is an invalid flag.", arg);
+			return (parse_error(args, message));
 	}
+	return (0);
 }
 
 /**
- * Parses the command (either 'md5' or 'sha256') and sets the corresponding mode in the global 'args' structure.
- * Validates the command and exits the program if an invalid command is provided.
+ * Parses the command ('md5', 'sha256' or 'whirlpool') and sets the corresponding mode of the request.
+ * Reports an invalid command on the output of the request.
  *
+ * @param args The request being parsed.
  * @param str The command string to parse.
+ * @return 0 on success, 1 if the command is invalid.
  */
-static void	parse_command(char *str)
+static int	parse_command(args_t *args, char *str)
 {
+	char	message[256];
+
 	if (strlen(str) == 3 || strlen(str) == 6 || strlen(str) == 9)
 	{
 		if (strncmp(str, "md5", 4) == 0)
-			args.command = 1;
+			args->command = 1;
 		else if (strncmp(str, "sha256", 7) == 0)
-			args.command = 2;
+			args->command = 2;
 		else if (strncmp(str, "whirlpool", 10) == 0)
-			args.command = 3;
-		else
-		{
-			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid command.\n", str);
-			exit(1);
-		}
+			args->command = 3;
 	}
-	else
+	if (!args->command)
 	{
-		fprintf(stderr, "ft_ssl: Error: '%s' is an invalid command.\n", str);
-		exit(1);
+		snprintf(message, sizeof(message), "'%s' is an invalid command.", str);
+		return (parse_error(args, message));
 	}
+	return (0);
+}
+
+/**
+ * Sets up an empty request writing its results to stdout.
+ *
+ * @param args The request.
+ */
+void	args_init(args_t *args)
+{
+	ft_bzero(args, sizeof(args_t));
+	args->delimiter = ',';
+	args->out = STDOUT_FILENO;
 }
 
 /**
  * Parses the command line arguments provided to the program.
  * This function handles the overall argument parsing logic, including parsing the command,
  * flags, and any additional arguments like file names or strings for hashing.
- * Sets the global 'args' structure with parsed data.
- * Exits the program if invalid arguments are provided or if argument limits are exceeded.
+ * Fills the request with parsed data; the request keeps pointers into 'av'.
+ * Invalid arguments or exceeded limits are reported and make the parsing fail,
+ * leaving the caller to decide whether to exit.
  *
+ * @param args The request, set up with args_init().
  * @param ac The argument count.
  * @param av The argument vector (array of strings).
+ * @return 0 on success, 1 if the arguments are invalid.
  */
-void	parse_args(int ac, char **av)
+int	parse_args(args_t *args, int ac, char **av)
 {
 	int	i = 2;
 	int	expect_string = 0;
 
 	if (ac < 2)
-		print_error_and_exit("usage: ft_ssl command [flags] [file/string]");
+		return (parse_error(args, "usage: ft_ssl command [flags] [file/string]"));
 	else
 	{
-		parse_command(av[1]);
+		if (parse_command(args, av[1]))
+			return (1);
 		while (i < ac)
 		{
-			if (av[i][0] == '-' && args.files[0] == NULL)
+			if (av[i][0] == '-' && args->files[0] == NULL)
 			{
 				if (av[i][1] == 's' && i + 1 < ac)
 					expect_string = 1;
-				else
-					parse_flags(av[i]);
+				else if (strcmp(av[i], "--files-from") == 0)
+				{
+					if (i + 1 >= ac)
+						return (parse_error(args, "'--files-from' expect a file after it."));
+					args->files_from = av[++i];
+				}
+				else if (strcmp(av[i], "--disk-order") == 0)
+					args->disk_order = 1;
+				else if (strcmp(av[i], "--fail-fast") == 0)
+					args->fail_fast = 1;
+				else if (strcmp(av[i], "--per-line") == 0)
+					args->per_line = 1;
+				else if (strcmp(av[i], "--batch") == 0)
+					args->batch = 1;
+				else if (strcmp(av[i], "--tar") == 0)
+					args->tar = 1;
+				else if (strcmp(av[i], "--binary") == 0 || strcmp(av[i], "--base64") == 0)
+				{
+					int	encoding = strcmp(av[i], "--binary") == 0 ? ENCODING_BINARY : ENCODING_BASE64;
+
+					if (args->encoding && args->encoding != encoding)
+						return (parse_error(args, "'--binary' and '--base64' cannot be used together."));
+					args->encoding = encoding;
+				}
+				else if (strcmp(av[i], "--field") == 0)
+				{
+					if (i + 1 >= ac || atoi(av[i + 1]) <= 0)
+						return (parse_error(args, "'--field' expect a field number after it."));
+					args->field = atoi(av[++i]);
+					args->per_line = 1;
+				}
+				else if (strcmp(av[i], "-d") == 0)
+				{
+					if (i + 1 >= ac || strlen(av[i + 1]) != 1 || av[i + 1][0] == '\n')
+						return (parse_error(args, "'-d' expect a single delimiter character after it."));
+					args->delimiter = av[++i][0];
+				}
+				else if (strcmp(av[i], "--index") == 0)
+				{
+					if (i + 1 >= ac)
+						return (parse_error(args, "'--index' expect an index file after it."));
+					args->index_file = av[++i];
+				}
+				else if (strcmp(av[i], "--prefix-file") == 0)
+				{
+					if (i + 1 >= ac)
+						return (parse_error(args, "'--prefix-file' expect a file after it."));
+					args->prefix_file = av[++i];
+				}
+				else if (strcmp(av[i], "-c") == 0)
+				{
+					if (i + 1 >= ac)
+						return (parse_error(args, "'-c' expect a checksum file after it."));
+					args->check_file = av[++i];
+				}
+				else if (parse_flags(args, av[i]))
+					return (1);
 			}
 			else if (expect_string)
 			{
-				args.strings[args.num_strings++] = av[i];
-				if (args.num_strings >= MAX_STRINGS)
-					print_error_and_exit("too many strings.");
+				args->strings[args->num_strings++] = av[i];
+				if (args->num_strings >= MAX_STRINGS)
+					return (parse_error(args, "too many strings."));
 				expect_string = 0;
 			}
 			else
 			{
-				args.files[args.num_files++] = av[i];
-				if (args.num_files >= MAX_FILES)
-					print_error_and_exit("too many files.");
+				args->files[args->num_files++] = av[i];
+				if (args->num_files >= MAX_FILES)
+					return (parse_error(args, "too many files."));
 			}
 			i++;
 		}
 		if (expect_string)
-			print_error_and_exit("'-s' expect a string after it.");
+			return (parse_error(args, "'-s' expect a string after it."));
+		if (args->fail_fast && !args->check_file)
+			return (parse_error(args, "'--fail-fast' can only be used with '-c'."));
+		if (args->tar && (args->per_line || args->check_file || args->recursive || args->files_from || args->echo))
+			return (parse_error(args, "'--tar' cannot be used with '--per-line', '-c', '-R', '-p' or '--files-from'."));
+		if (args->per_line && (args->check_file || args->recursive || args->files_from || args->echo))
+			return (parse_error(args, "'--per-line' cannot be used with '-c', '-R', '-p' or '--files-from'."));
+		if (args->encoding && args->check_file)
+			return (parse_error(args, "'--binary' and '--base64' cannot be used with '-c'."));
+		if (args->encoding == ENCODING_BINARY && (args->echo || args->recursive || args->files_from || args->disk_order))
+			return (parse_error(args, "'--binary' cannot be used with '-p', '-R', '--files-from' or '--disk-order'."));
+		if (args->batch && (args->per_line || args->tar || args->check_file || args->recursive || args->files_from
+			|| args->echo || args->index_file || args->num_strings || args->num_files || args->encoding))
+			return (parse_error(args, "'--batch' reads records from stdin and cannot be used with other inputs or modes."));
+		if (args->null_data && !args->files_from)
+			return (parse_error(args, "'-0' can only be used with '--files-from'."));
+		if (args->echo && args->files_from && strcmp(args->files_from, "-") == 0)
+			return (parse_error(args, "'-p' cannot be used when the file list is read from stdin."));
 	}
+	return (0);
 }
@@ -0,0 +1,358 @@
+#include "../includes/ft_ssl.h"
+#include <time.h>
+
+/**
+ * Size of a SHA256 digest, which is also the size of a PBKDF2 output block.
+ */
+#define PBKDF2_BLOCK_SIZE 32
+
+/**
+ * Iteration count used when -i is not given.
+ */
+#define PBKDF2_DEFAULT_ITERATIONS 10000
+
+/**
+ * Settings and results of a derivation run, shared by the workers.
+ * A task is one output block of one password; tasks are handed out
+ * MB_LANES at a time and derived together in the SIMD lanes.
+ */
+typedef struct	pbkdf2_s
+{
+	const hash_algo_t	*algo;
+	const uint8_t		*salt;
+	size_t				salt_len;
+	uint32_t			iterations;
+	size_t				key_len;
+	size_t				blocks;
+	const char			**passwords;
+	size_t				*lens;
+	size_t				count;
+	size_t				capacity;
+	uint8_t				*keys;
+	size_t				tasks;
+	size_t				next_task;
+}				pbkdf2_t;
+
+/**
+ * Interleaved state of MB_LANES tasks being derived together.
+ */
+typedef struct	pbkdf2_lanes_s
+{
+	uint32_t	inner[8][MB_LANES];
+	uint32_t	outer[8][MB_LANES];
+	uint32_t	u[8][MB_LANES];
+	uint32_t	t[8][MB_LANES];
+}				pbkdf2_lanes_t;
+
+static pbkdf2_t	pbkdf2;
+
+/**
+ * Prepares one lane: computes the HMAC pad states of the password and the
+ * first iteration U1 = HMAC(password, salt || INT(block)).
+ *
+ * @param lanes The lanes being prepared.
+ * @param lane The lane index.
+ * @param task The task derived in this lane.
+ */
+static void	setup_lane(pbkdf2_lanes_t *lanes, int lane, size_t task)
+{
+	size_t		password = task / pbkdf2.blocks;
+	uint32_t	block = __builtin_bswap32((uint32_t)(task % pbkdf2.blocks + 1));
+	hash_ctx_t	inner, outer, ctx;
+	uint8_t		digest[PBKDF2_BLOCK_SIZE];
+
+	hmac_init(pbkdf2.algo, (const uint8_t *)pbkdf2.passwords[password], pbkdf2.lens[password], &inner, &outer);
+	ctx = inner;
+	pbkdf2.algo->update(&ctx, pbkdf2.salt, pbkdf2.salt_len);
+	pbkdf2.algo->update(&ctx, (const uint8_t *)&block, sizeof(block));
+	pbkdf2.algo->final(&ctx, digest);
+	midstate_digest(pbkdf2.algo, &outer, digest, PBKDF2_BLOCK_SIZE, digest);
+	for (int word = 0; word < 8; word++)
+	{
+		uint32_t	value;
+		memcpy(&value, digest + word * 4, 4);
+		lanes->inner[word][lane] = inner.sha256.state[word];
+		lanes->outer[word][lane] = outer.sha256.state[word];
+		lanes->u[word][lane] = __builtin_bswap32(value);
+		lanes->t[word][lane] = lanes->u[word][lane];
+	}
+}
+
+/**
+ * Runs the remaining iterations of MB_LANES tasks at once.
+ * Every iteration is HMAC-SHA256 of the previous 32-byte result, so both
+ * the inner and the outer hash are a single block after the pad states,
+ * with a padding known in advance. The words stay in the interleaved lane
+ * layout from one compression to the next.
+ *
+ * @param lanes The prepared lanes.
+ */
+static void	iterate_lanes(pbkdf2_lanes_t *lanes)
+{
+	uint32_t	words[16][MB_LANES] = {{0}};
+	uint32_t	state[8][MB_LANES];
+
+	for (int lane = 0; lane < MB_LANES; lane++)
+	{
+		words[8][lane] = 0x80000000;
+		words[15][lane] = (64 + PBKDF2_BLOCK_SIZE) * 8;
+	}
+	for (uint32_t i = 1; i < pbkdf2.iterations; i++)
+	{
+		memcpy(words, lanes->u, sizeof(lanes->u));
+		memcpy(state, lanes->inner, sizeof(state));
+		sha256_compress_mb_words(state, words);
+		memcpy(words, state, sizeof(state));
+		memcpy(state, lanes->outer, sizeof(state));
+		sha256_compress_mb_words(state, words);
+		memcpy(lanes->u, state, sizeof(state));
+		for (int word = 0; word < 8; word++)
+			for (int lane = 0; lane < MB_LANES; lane++)
+				lanes->t[word][lane] ^= state[word][lane];
+	}
+}
+
+/**
+ * Copies the result of a lane into the derived key of its password.
+ * The last block is truncated to the requested key length.
+ *
+ * @param lanes The derived lanes.
+ * @param lane The lane index.
+ * @param task The task derived in this lane.
+ */
+static void	store_lane(pbkdf2_lanes_t *lanes, int lane, size_t task)
+{
+	uint8_t	block[PBKDF2_BLOCK_SIZE];
+	size_t	offset = (task % pbkdf2.blocks) * PBKDF2_BLOCK_SIZE;
+	size_t	size = pbkdf2.key_len - offset;
+
+	for (int word = 0; word < 8; word++)
+	{
+		uint32_t	value = __builtin_bswap32(lanes->t[word][lane]);
+		memcpy(block + word * 4, &value, 4);
+	}
+	if (size > PBKDF2_BLOCK_SIZE)
+		size = PBKDF2_BLOCK_SIZE;
+	memcpy(pbkdf2.keys + (task / pbkdf2.blocks) * pbkdf2.key_len + offset, block, size);
+}
+
+/**
+ * Main loop of a worker: derives groups of MB_LANES tasks until none is left.
+ * A short last group repeats its first task in the unused lanes.
+ *
+ * @param data Unused.
+ * @return Always NULL.
+ */
+static void	*pbkdf2_worker(void *data)
+{
+	pbkdf2_lanes_t	lanes;
+	size_t			first;
+
+	(void)data;
+	while ((first = __atomic_fetch_add(&pbkdf2.next_task, MB_LANES, __ATOMIC_RELAXED)) < pbkdf2.tasks)
+	{
+		for (int lane = 0; lane < MB_LANES; lane++)
+			setup_lane(&lanes, lane, first + lane < pbkdf2.tasks ? first + lane : first);
+		iterate_lanes(&lanes);
+		for (int lane = 0; lane < MB_LANES && first + lane < pbkdf2.tasks; lane++)
+			store_lane(&lanes, lane, first + lane);
+	}
+	return (NULL);
+}
+
+/**
+ * Derives every key on one thread per core.
+ */
+static void	run_workers(void)
+{
+	pthread_t	threads[ENGINE_MAX_THREADS];
+	int			count = engine_threads();
+	int			started = 0;
+
+	while (started < count && (size_t)started * MB_LANES < pbkdf2.tasks
+		&& pthread_create(&threads[started], NULL, pbkdf2_worker, NULL) == 0)
+		started++;
+	if (started == 0)
+		pbkdf2_worker(NULL);
+	for (int i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+}
+
+/**
+ * Adds a password to the list of keys to derive.
+ *
+ * @param password The password, not NUL-terminated.
+ * @param len The length of the password.
+ */
+static void	add_password(const char *password, size_t len)
+{
+	if (pbkdf2.count == pbkdf2.capacity)
+	{
+		size_t		capacity = pbkdf2.capacity ? pbkdf2.capacity * 2 : 64;
+		const char	**passwords = realloc(pbkdf2.passwords, capacity * sizeof(char *));
+		size_t		*lens = passwords ? realloc(pbkdf2.lens, capacity * sizeof(size_t)) : NULL;
+		if (!passwords || !lens)
+			print_error_and_exit("realloc() failed");
+		pbkdf2.passwords = passwords;
+		pbkdf2.lens = lens;
+		pbkdf2.capacity = capacity;
+	}
+	pbkdf2.passwords[pbkdf2.count] = password;
+	pbkdf2.lens[pbkdf2.count] = len;
+	pbkdf2.count++;
+}
+
+/**
+ * Adds every line of a mapped file as a password.
+ *
+ * @param content The content of the file.
+ * @param size The size of the file.
+ */
+static void	add_password_lines(const char *content, size_t size)
+{
+	const char	*pos = content;
+	const char	*end = content + size;
+
+	while (pos < end)
+	{
+		const char	*next = memchr(pos, '\n', end - pos);
+		size_t		len;
+
+		if (!next)
+			next = end;
+		len = next - pos;
+		if (len && pos[len - 1] == '\r')
+			len--;
+		add_password(pos, len);
+		pos = next + 1;
+	}
+}
+
+/**
+ * Displays the derived keys, in the order the passwords were given.
+ * Keys of passwords read from a file are displayed alone, one per line.
+ *
+ * @param args The request, holding the -q and -r flags.
+ * @param given The number of passwords given with -p.
+ */
+static void	display_keys(const args_t *args, size_t given)
+{
+	char	*hex = arena_scratch(pbkdf2.key_len * 2 + 1);
+
+	for (size_t i = 0; i < pbkdf2.count; i++)
+	{
+		hex_encode(pbkdf2.keys + i * pbkdf2.key_len, pbkdf2.key_len, hex);
+		hex[pbkdf2.key_len * 2] = '\0';
+		if (args->quiet || i >= given)
+			display_printf(args, "%s\n", hex);
+		else if (args->reverse)
+			display_printf(args, "%s \"%s\"\n", hex, (char *)pbkdf2.passwords[i]);
+		else
+			display_printf(args, "PBKDF2-SHA256 (\"%s\") = %s\n", (char *)pbkdf2.passwords[i], hex);
+	}
+}
+
+/**
+ * Parses the arguments of the pbkdf2 command.
+ * Usage: ft_ssl pbkdf2 -S salt [-i iterations] [-l length] [-q] [-r] [-v]
+ *        [-p password]... [--passwords file]
+ *
+ * @param args The request, receiving the -q and -r flags.
+ * @param ac The argument count.
+ * @param av The argument vector.
+ * @param file Pointer receiving the --passwords file.
+ * @param verbose Pointer set to 1 with -v.
+ */
+static void	parse_pbkdf2_args(args_t *args, int ac, char **av, const char **file, int *verbose)
+{
+	pbkdf2.iterations = PBKDF2_DEFAULT_ITERATIONS;
+	pbkdf2.key_len = PBKDF2_BLOCK_SIZE;
+	for (int i = 2; i < ac; i++)
+	{
+		if (strcmp(av[i], "-S") == 0 && i + 1 < ac)
+		{
+			pbkdf2.salt = (const uint8_t *)av[++i];
+			pbkdf2.salt_len = strlen(av[i]);
+		}
+		else if (strcmp(av[i], "-i") == 0 && i + 1 < ac && atol(av[i + 1]) > 0)
+			pbkdf2.iterations = (uint32_t)strtoul(av[++i], NULL, 10);
+		else if (strcmp(av[i], "-l") == 0 && i + 1 < ac && atol(av[i + 1]) > 0)
+			pbkdf2.key_len = strtoul(av[++i], NULL, 10);
+		else if (strcmp(av[i], "-p") == 0 && i + 1 < ac)
+		{
+			i++;
+			add_password(av[i], strlen(av[i]));
+		}
+		else if (strcmp(av[i], "--passwords") == 0 && i + 1 < ac)
+			*file = av[++i];
+		else if (strcmp(av[i], "-q") == 0)
+			args->quiet = 1;
+		else if (strcmp(av[i], "-r") == 0)
+			args->reverse = 1;
+		else if (strcmp(av[i], "-v") == 0)
+			*verbose = 1;
+		else
+		{
+			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid flag.\n", av[i]);
+			exit(1);
+		}
+	}
+	if (!pbkdf2.salt || (!pbkdf2.count && !*file))
+		print_error_and_exit("usage: ft_ssl pbkdf2 -S salt [-i iterations] [-l length] [-q] [-r] [-v] [-p password]... [--passwords file]");
+}
+
+/**
+ * Derives keys from passwords with PBKDF2-HMAC-SHA256 (RFC 8018).
+ * Each output block of each password is a task; tasks are derived MB_LANES
+ * at a time with the multi-lane SHA256 kernel, on one thread per core.
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "pbkdf2".
+ * @return 0 on success, 1 if the password file could not be read.
+ */
+int	pbkdf2_command(int ac, char **av)
+{
+	const char		*file = NULL;
+	char			*content = NULL;
+	size_t			size = 0;
+	int				mapped = 0;
+	int				verbose = 0;
+	size_t			given;
+	args_t			args;
+	struct timespec	begin, done;
+
+	args_init(&args);
+	parse_pbkdf2_args(&args, ac, av, &file, &verbose);
+	given = pbkdf2.count;
+	if (file)
+	{
+		if (!(content = map_file(&args, file, &size, &mapped)))
+			return (1);
+		add_password_lines(content, size);
+	}
+	pbkdf2.algo = get_algo(2);
+	pbkdf2.blocks = (pbkdf2.key_len + PBKDF2_BLOCK_SIZE - 1) / PBKDF2_BLOCK_SIZE;
+	pbkdf2.tasks = pbkdf2.count * pbkdf2.blocks;
+	if (!(pbkdf2.keys = malloc(pbkdf2.count * pbkdf2.key_len + 1)))
+		print_error_and_exit("malloc() failed");
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	run_workers();
+	clock_gettime(CLOCK_MONOTONIC, &done);
+	display_keys(&args, given);
+	if (verbose)
+	{
+		double	elapsed = (done.tv_sec - begin.tv_sec) + (done.tv_nsec - begin.tv_nsec) / 1e9;
+		double	iterations = (double)pbkdf2.tasks * pbkdf2.iterations;
+		fprintf(stderr, "ft_ssl: pbkdf2: %zu key%s, %.0f iterations in %.2fs (%.0f iterations/s)\n",
+			pbkdf2.count, pbkdf2.count > 1 ? "s" : "", iterations, elapsed,
+			elapsed > 0 ? iterations / elapsed : 0);
+	}
+
+	if (content)
+		unmap_file(content, size, mapped);
+	free(pbkdf2.keys);
+	free(pbkdf2.passwords);
+	free(pbkdf2.lens);
+	return (0);
+}
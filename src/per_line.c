@@ -0,0 +1,220 @@
+#include "../includes/ft_ssl.h"
+
+/**
+ * Initial size of the read buffer, doubled when a single record does not fit.
+ */
+#define PER_LINE_CHUNK (1 << 20)
+
+/**
+ * Number of records hashed together, and formatted at once into the output.
+ */
+#define PER_LINE_BATCH 256
+
+/* 16 bytes compared at once by the separator scanner */
+typedef char		scan_vec_t __attribute__((vector_size(16)));
+typedef uint64_t	scan_mask_t __attribute__((vector_size(16)));
+
+/**
+ * Records waiting to be hashed. They point into the read buffer, so the batch
+ * is flushed before the buffer is moved or refilled.
+ */
+typedef struct	per_line_s
+{
+	const args_t		*args;
+	const hash_algo_t	*algo;
+	const hash_ctx_t	*midstate;
+	scan_vec_t			newlines;
+	scan_vec_t			delimiters;
+	const uint8_t		*msgs[PER_LINE_BATCH];
+	size_t				lens[PER_LINE_BATCH];
+	size_t				count;
+}				per_line_t;
+
+/**
+ * Finds the next newline or field delimiter.
+ * Sixteen bytes are compared against both separators at once; the result is
+ * read back as two 64-bit words whose lowest set bit gives the position
+ * (the scanner assumes a little-endian target).
+ *
+ * @param pl The batch, holding the separators broadcast to every byte.
+ * @param pos The first byte to scan.
+ * @param end The end of the buffer.
+ * @return The position of the separator, or 'end' if there is none.
+ */
+static const char	*find_separator(const per_line_t *pl, const char *pos, const char *end)
+{
+	scan_vec_t	bytes;
+	scan_mask_t	hits;
+
+	for (; pos + 16 <= end; pos += 16)
+	{
+		memcpy(&bytes, pos, 16);
+		hits = (scan_mask_t)((bytes == pl->newlines) | (bytes == pl->delimiters));
+		if (hits[0])
+			return (pos + (__builtin_ctzll(hits[0]) >> 3));
+		if (hits[1])
+			return (pos + 8 + (__builtin_ctzll(hits[1]) >> 3));
+	}
+	while (pos < end && *pos != '\n' && *pos != pl->delimiters[0])
+		pos++;
+	return (pos);
+}
+
+/**
+ * Hashes the pending records and prints their digests, one per line, in order.
+ *
+ * @param pl The batch, emptied by this function.
+ */
+static void	flush_records(per_line_t *pl)
+{
+	uint8_t	digests[PER_LINE_BATCH][MAX_DIGEST_SIZE];
+	uint8_t	*outputs[PER_LINE_BATCH];
+	size_t	digest_size = pl->algo->digest_size;
+	int		binary = pl->args->encoding == ENCODING_BINARY;
+	char	*out;
+	size_t	size = 0;
+
+	for (size_t i = 0; i < pl->count; i++)
+		outputs[i] = digests[i];
+	if (pl->midstate)
+		midstate_digest_batch(pl->algo, pl->midstate, pl->msgs, pl->lens, outputs, pl->count);
+	else
+		digest_batch(pl->algo, pl->msgs, pl->lens, outputs, pl->count);
+	out = display_reserve(pl->args, pl->count * (digest_size * 2 + 1));
+	for (size_t i = 0; i < pl->count; i++)
+	{
+		if (binary)
+		{
+			memcpy(out + size, digests[i], digest_size);
+			size += digest_size;
+			continue;
+		}
+		size += display_encode(pl->args, digests[i], digest_size, out + size);
+		out[size++] = '\n';
+	}
+	display_commit(pl->args, size);
+	pl->count = 0;
+}
+
+/**
+ * Adds a record to the batch, hashing the batch when it is full.
+ * A trailing '\r' is dropped so that CRLF files give the same digests.
+ *
+ * @param pl The batch.
+ * @param record The record.
+ * @param len The length of the record.
+ */
+static void	add_record(per_line_t *pl, const char *record, size_t len)
+{
+	if (len && record[len - 1] == '\r')
+		len--;
+	pl->msgs[pl->count] = (const uint8_t *)record;
+	pl->lens[pl->count] = len;
+	if (++pl->count == PER_LINE_BATCH)
+		flush_records(pl);
+}
+
+/**
+ * Splits the complete lines of a buffer into records.
+ * With --field, a single pass over each line finds the delimiters bounding
+ * the selected field; lines with fewer fields give an empty record, so that
+ * the output stays aligned with the input.
+ *
+ * @param pl The batch.
+ * @param buffer The buffer.
+ * @param len The number of bytes in the buffer.
+ * @param eof Whether the buffer ends the input (its last line may then lack a newline).
+ * @return The number of bytes consumed; the rest is an incomplete line.
+ */
+static size_t	split_records(per_line_t *pl, const char *buffer, size_t len, int eof)
+{
+	const char	*pos = buffer;
+	const char	*end = buffer + len;
+
+	while (pos < end)
+	{
+		const char	*line = pos;
+		const char	*start = line;
+		const char	*stop = NULL;
+		const char	*sep;
+		int			index = 1;
+
+		while ((sep = find_separator(pl, pos, end)) < end && *sep != '\n')
+		{
+			if (index == pl->args->field)
+				stop = sep;
+			if (++index == pl->args->field)
+				start = sep + 1;
+			pos = sep + 1;
+		}
+		if (sep == end && !eof)
+			return (line - buffer);
+		if (index < pl->args->field)
+			start = sep;
+		add_record(pl, start, (stop ? stop : sep) - start);
+		pos = sep + 1;
+	}
+	return (len);
+}
+
+/**
+ * Hashes every line (or the selected field of every line) of a file on its
+ * own and prints one digest per line, in input order.
+ * The file is streamed through a buffer that only grows to fit the longest
+ * line.
+ *
+ * @param args The request.
+ * @param path The path of the file, or "-" for stdin.
+ * @return 0 on success, 1 if the file could not be read.
+ */
+int	hash_lines(const args_t *args, const char *path)
+{
+	per_line_t	pl;
+	size_t		capacity = PER_LINE_CHUNK;
+	size_t		kept = 0;
+	ssize_t		bytes_read;
+	char		*buffer;
+	int			fd = STDIN_FILENO;
+
+	if (strcmp(path, "-") != 0 && (fd = open(path, O_RDONLY)) == -1)
+	{
+		print_error(args, (char *)path, strerror(errno));
+		return (1);
+	}
+	if (!(buffer = malloc(capacity)))
+		print_error_and_exit("malloc() failed");
+	ft_bzero(&pl, sizeof(pl));
+	pl.args = args;
+	pl.algo = get_algo(args->command);
+	pl.midstate = args->prefix_file ? &args->midstate : NULL;
+	for (int i = 0; i < 16; i++)
+	{
+		pl.newlines[i] = '\n';
+		pl.delimiters[i] = args->field ? args->delimiter : '\n';
+	}
+	while ((bytes_read = read(fd, buffer + kept, capacity - kept)) > 0)
+	{
+		size_t	len = kept + bytes_read;
+		size_t	used = split_records(&pl, buffer, len, 0);
+
+		flush_records(&pl);
+		kept = len - used;
+		memmove(buffer, buffer + used, kept);
+		if (kept == capacity)
+		{
+			char	*bigger = realloc(buffer, capacity * 2);
+			if (!bigger)
+				print_error_and_exit("realloc() failed");
+			buffer = bigger;
+			capacity *= 2;
+		}
+	}
+	if (bytes_read == -1)
+		print_error(args, (char *)path, strerror(errno));
+	split_records(&pl, buffer, kept, 1);
+	flush_records(&pl);
+	free(buffer);
+	if (fd != STDIN_FILENO)
+		close(fd);
+	return (bytes_read == -1);
+}
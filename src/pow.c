@@ -0,0 +1,355 @@
+#include "../includes/ft_ssl.h"
+#include <time.h>
+
+/**
+ * Length of a nonce: the 64-bit nonce is appended as fixed-width lowercase
+ * hexadecimal, so incrementing it never moves the padding.
+ */
+#define POW_NONCE_LEN 16
+
+/**
+ * Number of consecutive nonces claimed by a worker at a time; they are
+ * split evenly between the SIMD lanes.
+ */
+#define POW_CHUNK 65536
+
+/**
+ * Settings and result of a proof-of-work search, shared by the workers.
+ * 'tail' is the template of the last block(s): the prefix bytes left
+ * pending in the midstate, the nonce, the padding and the total length.
+ */
+typedef struct	pow_s
+{
+	const hash_algo_t	*algo;
+	compress_mb_t		compress;
+	int					state_words;
+	int					big_endian;
+	int					bits;
+	hash_ctx_t			midstate;
+	uint32_t			iv[8];
+	uint8_t				tail[128];
+	int					tail_blocks;
+	size_t				nonce_offset;
+	uint64_t			next_chunk;
+	int					found;
+	uint64_t			nonce;
+	uint8_t				digest[MAX_DIGEST_SIZE];
+	pthread_mutex_t		lock;
+}				pow_t;
+
+/**
+ * Number of hashes computed by a worker.
+ */
+typedef struct	pow_worker_s
+{
+	pthread_t	thread;
+	uint64_t	hashes;
+}				pow_worker_t;
+
+static pow_t	pow_state = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * Writes a nonce as POW_NONCE_LEN lowercase hexadecimal digits.
+ *
+ * @param dst The destination, not NUL-terminated.
+ * @param nonce The nonce.
+ */
+static void	write_nonce(uint8_t *dst, uint64_t nonce)
+{
+	for (int i = POW_NONCE_LEN - 1; i >= 0; i--)
+	{
+		dst[i] = "0123456789abcdef"[nonce & 15];
+		nonce >>= 4;
+	}
+}
+
+/**
+ * Increments a hexadecimal nonce in place, directly in the message block.
+ *
+ * @param nonce The POW_NONCE_LEN digits of the nonce.
+ */
+static void	increment_nonce(uint8_t *nonce)
+{
+	for (int i = POW_NONCE_LEN - 1; i >= 0; i--)
+	{
+		if (nonce[i] == '9')
+		{
+			nonce[i] = 'a';
+			return;
+		}
+		if (nonce[i] != 'f')
+		{
+			nonce[i]++;
+			return;
+		}
+		nonce[i] = '0';
+	}
+}
+
+/**
+ * Tells whether a digest starts with at least pow_state.bits zero bits.
+ *
+ * @param digest The raw digest.
+ * @return 1 if it does, 0 otherwise.
+ */
+static int	has_leading_zeros(const uint8_t *digest)
+{
+	int	bits = pow_state.bits;
+	int	i = 0;
+
+	for (; bits >= 8; bits -= 8)
+		if (digest[i++])
+			return (0);
+	return (bits == 0 || (digest[i] >> (8 - bits)) == 0);
+}
+
+/**
+ * Records a solution, unless another worker found one first.
+ *
+ * @param nonce The nonce.
+ * @param digest The digest of prefix || nonce.
+ */
+static void	report(uint64_t nonce, const uint8_t *digest)
+{
+	pthread_mutex_lock(&pow_state.lock);
+	if (!pow_state.found)
+	{
+		pow_state.found = 1;
+		pow_state.nonce = nonce;
+		memcpy(pow_state.digest, digest, pow_state.algo->digest_size);
+	}
+	pthread_mutex_unlock(&pow_state.lock);
+}
+
+/**
+ * Searches a chunk with the multi-lane kernel.
+ * Each lane owns a copy of the tail template and walks its own slice of the
+ * chunk by incrementing the nonce in place; only the tail block(s) are
+ * compressed, starting from the cached midstate.
+ *
+ * @param blocks The tail blocks of the lanes.
+ * @param start The first nonce of the chunk.
+ */
+static void	search_lanes(uint8_t blocks[MB_LANES][128], uint64_t start)
+{
+	const uint64_t	per_lane = POW_CHUNK / MB_LANES;
+	const uint8_t	*ptrs[2][MB_LANES];
+	uint32_t		state[8][MB_LANES];
+	uint8_t			digest[MAX_DIGEST_SIZE];
+
+	for (int lane = 0; lane < MB_LANES; lane++)
+	{
+		write_nonce(blocks[lane] + pow_state.nonce_offset, start + lane * per_lane);
+		ptrs[0][lane] = blocks[lane];
+		ptrs[1][lane] = blocks[lane] + 64;
+	}
+	for (uint64_t i = 0; i < per_lane; i++)
+	{
+		for (int word = 0; word < pow_state.state_words; word++)
+			for (int lane = 0; lane < MB_LANES; lane++)
+				state[word][lane] = pow_state.iv[word];
+		for (int block = 0; block < pow_state.tail_blocks; block++)
+			pow_state.compress(state, ptrs[block]);
+		for (int lane = 0; lane < MB_LANES; lane++)
+		{
+			uint32_t	first = state[0][lane];
+			if (!pow_state.big_endian)
+				first = __builtin_bswap32(first);
+			if (pow_state.bits < 32 && first >> (32 - pow_state.bits))
+				continue;
+			for (int word = 0; word < pow_state.state_words; word++)
+			{
+				uint32_t	value = state[word][lane];
+				if (pow_state.big_endian)
+					value = __builtin_bswap32(value);
+				memcpy(digest + word * 4, &value, 4);
+			}
+			if (has_leading_zeros(digest))
+				report(start + lane * per_lane + i, digest);
+		}
+		for (int lane = 0; lane < MB_LANES; lane++)
+			increment_nonce(blocks[lane] + pow_state.nonce_offset);
+	}
+}
+
+/**
+ * Searches a chunk one nonce at a time, for algorithms without a
+ * multi-lane kernel.
+ *
+ * @param start The first nonce of the chunk.
+ */
+static void	search_scalar(uint64_t start)
+{
+	uint8_t	nonce[POW_NONCE_LEN];
+	uint8_t	digest[MAX_DIGEST_SIZE];
+
+	write_nonce(nonce, start);
+	for (uint64_t i = 0; i < POW_CHUNK; i++)
+	{
+		midstate_digest(pow_state.algo, &pow_state.midstate, nonce, POW_NONCE_LEN, digest);
+		if (has_leading_zeros(digest))
+			report(start + i, digest);
+		increment_nonce(nonce);
+	}
+}
+
+/**
+ * Main loop of a worker: claims chunks of the nonce space until a solution
+ * has been found.
+ *
+ * @param data Pointer to the pow_worker_t of this worker.
+ * @return Always NULL.
+ */
+static void	*pow_worker(void *data)
+{
+	pow_worker_t	*worker = data;
+	uint8_t			blocks[MB_LANES][128];
+	uint64_t		chunk;
+
+	for (int lane = 0; lane < MB_LANES; lane++)
+		memcpy(blocks[lane], pow_state.tail, sizeof(pow_state.tail));
+	while (!__atomic_load_n(&pow_state.found, __ATOMIC_RELAXED)
+		&& (chunk = __atomic_fetch_add(&pow_state.next_chunk, 1, __ATOMIC_RELAXED)) < UINT64_MAX / POW_CHUNK)
+	{
+		if (pow_state.compress)
+			search_lanes(blocks, chunk * POW_CHUNK);
+		else
+			search_scalar(chunk * POW_CHUNK);
+		worker->hashes += POW_CHUNK;
+	}
+	return (NULL);
+}
+
+/**
+ * Caches the midstate of the prefix and builds the tail template.
+ * With a multi-lane kernel, the midstate is the state after the last
+ * complete block of the prefix; the remaining bytes go into the tail, in
+ * front of the nonce, followed by the padding and the total length.
+ *
+ * @param args The request holding the algorithm.
+ * @param prefix The prefix.
+ * @param len The length of the prefix.
+ */
+static void	setup_prefix(const args_t *args, const uint8_t *prefix, size_t len)
+{
+	size_t		pending = len & 63;
+	uint64_t	bit_len = (uint64_t)(len + POW_NONCE_LEN) * 8;
+
+	midstate_init(pow_state.algo, prefix, len, &pow_state.midstate);
+	if (args->command == 1)
+	{
+		memcpy(pow_state.iv, &pow_state.midstate.md5.state, sizeof(md5_group_t));
+		pow_state.compress = md5_compress_mb;
+		pow_state.state_words = 4;
+	}
+	else if (args->command == 2)
+	{
+		memcpy(pow_state.iv, pow_state.midstate.sha256.state, sizeof(pow_state.midstate.sha256.state));
+		pow_state.compress = sha256_compress_mb;
+		pow_state.state_words = 8;
+		pow_state.big_endian = 1;
+		bit_len = __builtin_bswap64(bit_len);
+	}
+	memcpy(pow_state.tail, prefix + len - pending, pending);
+	pow_state.nonce_offset = pending;
+	pow_state.tail[pending + POW_NONCE_LEN] = 0x80;
+	pow_state.tail_blocks = (pending + POW_NONCE_LEN + 9 <= 64) ? 1 : 2;
+	memcpy(pow_state.tail + pow_state.tail_blocks * 64 - 8, &bit_len, 8);
+}
+
+/**
+ * Parses the arguments of the pow command.
+ * Usage: ft_ssl pow [-a md5|sha256|whirlpool] -d bits prefix
+ *
+ * @param args The request, receiving the algorithm.
+ * @param ac The argument count.
+ * @param av The argument vector.
+ * @return The prefix.
+ */
+static char	*parse_pow_args(args_t *args, int ac, char **av)
+{
+	int	i = 2;
+
+	args->command = 2;
+	while (i < ac - 1 && av[i][0] == '-')
+	{
+		if (strcmp(av[i], "-a") == 0 && i + 1 < ac)
+		{
+			if (!(args->command = find_algo(av[++i])))
+			{
+				fprintf(stderr, "ft_ssl: Error: '%s' is an invalid algorithm.\n", av[i]);
+				exit(1);
+			}
+		}
+		else if (strcmp(av[i], "-d") == 0 && i + 1 < ac)
+			pow_state.bits = atoi(av[++i]);
+		else
+		{
+			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid flag.\n", av[i]);
+			exit(1);
+		}
+		i++;
+	}
+	if (i != ac - 1 || pow_state.bits <= 0
+		|| pow_state.bits > (int)get_algo(args->command)->digest_size * 8)
+		print_error_and_exit("usage: ft_ssl pow [-a md5|sha256|whirlpool] -d bits prefix");
+	return (av[i]);
+}
+
+/**
+ * Finds a nonce such that the digest of prefix || nonce starts with the
+ * requested number of zero bits. The nonce is appended as 16 hexadecimal
+ * digits. The nonce space is split in chunks between one worker per core,
+ * and each chunk between the SIMD lanes. Prints "nonce digest" and reports
+ * the hash rate on stderr.
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "pow".
+ * @return 0 when a nonce was found, 1 otherwise.
+ */
+int	pow_command(int ac, char **av)
+{
+	args_t			args;
+	char			*prefix;
+	pow_worker_t	workers[ENGINE_MAX_THREADS];
+	int				count = engine_threads();
+	int				started = 0;
+	uint64_t		hashes = 0;
+	struct timespec	begin, done;
+
+	args_init(&args);
+	prefix = parse_pow_args(&args, ac, av);
+	pow_state.algo = get_algo(args.command);
+	setup_prefix(&args, (const uint8_t *)prefix, strlen(prefix));
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (int i = 0; i < count; i++)
+		workers[i].hashes = 0;
+	while (started < count
+		&& pthread_create(&workers[started].thread, NULL, pow_worker, &workers[started]) == 0)
+		started++;
+	if (started == 0)
+		pow_worker(&workers[started++]);
+	else
+		for (int i = 0; i < started; i++)
+			pthread_join(workers[i].thread, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &done);
+	for (int i = 0; i < started; i++)
+		hashes += workers[i].hashes;
+
+	if (pow_state.found)
+	{
+		uint8_t	nonce[POW_NONCE_LEN + 1] = {0};
+		char	hex[MAX_DIGEST_SIZE * 2 + 1];
+
+		hex_encode(pow_state.digest, pow_state.algo->digest_size, hex);
+		hex[pow_state.algo->digest_size * 2] = '\0';
+		write_nonce(nonce, pow_state.nonce);
+		display_printf(&args, "%s %s\n", (char *)nonce, hex);
+	}
+	output_flush();
+	double	elapsed = (done.tv_sec - begin.tv_sec) + (done.tv_nsec - begin.tv_nsec) / 1e9;
+	fprintf(stderr, "ft_ssl: pow: %llu hashes in %.2fs (%.0f hashes/s)\n",
+		(unsigned long long)hashes, elapsed, elapsed > 0 ? hashes / elapsed : 0);
+	return (!pow_state.found);
+}
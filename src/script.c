@@ -0,0 +1,373 @@
+#include "../includes/ft_ssl.h"
+#include <sys/uio.h>
+
+/**
+ * Number of bytes read from the script at a time. The buffer only grows
+ * beyond this to hold a longer line.
+ */
+#define SCRIPT_CHUNK 65536
+
+/**
+ * Number of commands in flight between the reader and the ordered writer.
+ */
+#define SCRIPT_WINDOW 1024
+
+/**
+ * Number of command outputs written by a single writev().
+ */
+#define SCRIPT_IOV 64
+
+/**
+ * One command of the script.
+ * The line is copied into 'line' and split in place into 'tokens'; both
+ * arrays belong to the window slot and only grow, so that a long script is
+ * tokenized without any allocation once the window has warmed up.
+ */
+typedef struct	script_cmd_s
+{
+	args_t			args;
+	output_buffer_t	output;
+	char			*line;
+	size_t			line_capacity;
+	char			**tokens;
+	size_t			tokens_capacity;
+	int				status;
+	int				done;
+	struct script_s	*script;
+}				script_cmd_t;
+
+/**
+ * Window of commands shared by the reader (main thread) and the workers.
+ * Commands are numbered in script order; 'head' is the next one to print and
+ * 'tail' the next one to read.
+ */
+typedef struct	script_s
+{
+	pthread_mutex_t	lock;
+	pthread_cond_t	changed;
+	script_cmd_t	window[SCRIPT_WINDOW];
+	size_t			head;
+	size_t			tail;
+	int				from_stdin;
+	int				status;
+}				script_t;
+
+/**
+ * Worker job running one command of the script into its capture buffer.
+ *
+ * @param path Unused.
+ * @param data Pointer to the script_cmd_t to run.
+ */
+static void	run_command(char *path, void *data)
+{
+	script_cmd_t	*cmd = data;
+	int				status = ft_hash(&cmd->args);
+
+	(void)path;
+	pthread_mutex_lock(&cmd->script->lock);
+	cmd->status = status;
+	cmd->done = 1;
+	pthread_cond_broadcast(&cmd->script->changed);
+	pthread_mutex_unlock(&cmd->script->lock);
+}
+
+/**
+ * Writes the output of the finished commands at the head of the window, in
+ * script order, up to SCRIPT_IOV of them per writev().
+ *
+ * @param script The script.
+ * @param wait Whether to wait for the head command when it is not done yet.
+ * @return The number of commands written.
+ */
+static size_t	write_done(script_t *script, int wait)
+{
+	struct iovec	iov[SCRIPT_IOV];
+	size_t			count = 0;
+	int				chunks = 0;
+
+	pthread_mutex_lock(&script->lock);
+	while (wait && script->head < script->tail && !script->window[script->head % SCRIPT_WINDOW].done)
+		pthread_cond_wait(&script->changed, &script->lock);
+	while (script->head + count < script->tail && count < SCRIPT_IOV
+		&& script->window[(script->head + count) % SCRIPT_WINDOW].done)
+		count++;
+	pthread_mutex_unlock(&script->lock);
+	for (size_t i = 0; i < count; i++)
+	{
+		script_cmd_t	*cmd = &script->window[(script->head + i) % SCRIPT_WINDOW];
+
+		script->status |= cmd->status;
+		if (cmd->output.len)
+		{
+			iov[chunks].iov_base = cmd->output.data;
+			iov[chunks++].iov_len = cmd->output.len;
+		}
+	}
+	for (int i = 0; i < chunks;)
+	{
+		ssize_t	written = writev(STDOUT_FILENO, iov + i, chunks - i);
+
+		if (written == -1 && errno == EINTR)
+			continue;
+		if (written == -1)
+		{
+			perror("ft_ssl: writev() failed");
+			break;
+		}
+		while (i < chunks && (size_t)written >= iov[i].iov_len)
+			written -= iov[i++].iov_len;
+		if (i < chunks)
+		{
+			iov[i].iov_base = (char *)iov[i].iov_base + written;
+			iov[i].iov_len -= written;
+		}
+	}
+	script->head += count;
+	return (count);
+}
+
+/**
+ * Writes the output of every command read so far, waiting for them.
+ *
+ * @param script The script.
+ */
+static void	drain(script_t *script)
+{
+	while (script->head < script->tail)
+		write_done(script, 1);
+}
+
+/**
+ * Copies a line into the next window slot and splits it into tokens on
+ * spaces and tabs, waiting for the slot to be written if the window is full.
+ *
+ * @param script The script.
+ * @param line The line, not NUL-terminated.
+ * @param len The length of the line.
+ * @return The slot, its tokens NULL-terminated.
+ */
+static script_cmd_t	*tokenize(script_t *script, const char *line, size_t len)
+{
+	script_cmd_t	*cmd;
+	size_t			count = 0;
+
+	while (script->tail - script->head == SCRIPT_WINDOW)
+		write_done(script, 1);
+	cmd = &script->window[script->tail % SCRIPT_WINDOW];
+	if (cmd->line_capacity < len + 1)
+	{
+		free(cmd->line);
+		free(cmd->tokens);
+		cmd->line_capacity = len + 1;
+		cmd->tokens_capacity = len / 2 + 2;
+		cmd->line = malloc(cmd->line_capacity);
+		cmd->tokens = malloc(cmd->tokens_capacity * sizeof(char *));
+		if (!cmd->line || !cmd->tokens)
+			print_error_and_exit("malloc() failed");
+	}
+	memcpy(cmd->line, line, len);
+	cmd->line[len] = '\0';
+	for (char *pos = cmd->line; *pos;)
+	{
+		while (*pos == ' ' || *pos == '\t')
+			*pos++ = '\0';
+		if (!*pos)
+			break;
+		cmd->tokens[count++] = pos;
+		while (*pos && *pos != ' ' && *pos != '\t')
+			pos++;
+	}
+	cmd->tokens[count] = NULL;
+	return (cmd);
+}
+
+/**
+ * Tells whether a command would read stdin, which holds the script itself
+ * when it is read from "-".
+ *
+ * @param args The request.
+ * @return 1 if the command reads stdin, 0 otherwise.
+ */
+static int	reads_stdin(const args_t *args)
+{
+	return (args->echo
+		|| (args->files_from && strcmp(args->files_from, "-") == 0)
+		|| (args->check_file && strcmp(args->check_file, "-") == 0));
+}
+
+/**
+ * Checks an "execute" line and fills the request of its slot.
+ * Errors are reported in the capture buffer of the slot, so that they are
+ * printed in order with the results.
+ *
+ * @param script The script.
+ * @param cmd The slot.
+ * @param count The number of tokens.
+ * @return 0 if the command can run, 1 otherwise.
+ */
+static int	prepare_command(script_t *script, script_cmd_t *cmd, int count)
+{
+	if (execute_prepare(&cmd->args, cmd->tokens, count, "script"))
+		return (1);
+	if (script->from_stdin && reads_stdin(&cmd->args))
+	{
+		print_request_error(&cmd->args, "stdin cannot be read when the script is read from stdin.");
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * Runs a command that uses the worker pool itself or streams its output:
+ * the commands before it are printed first, then it runs alone on the main
+ * thread, writing straight to stdout.
+ *
+ * @param script The script.
+ * @param cmd The slot of the command.
+ */
+static void	run_alone(script_t *script, script_cmd_t *cmd)
+{
+	drain(script);
+	engine_finish();
+	cmd->args.capture = NULL;
+	script->status |= ft_hash(&cmd->args);
+	engine_start(0);
+}
+
+/**
+ * Handles one line of the script.
+ * Commands hashing strings or plain files run on the worker pool, several at
+ * a time; the others run alone, in order.
+ *
+ * @param script The script.
+ * @param line The line, not NUL-terminated.
+ * @param len The length of the line.
+ * @return 0 on "exit", 1 otherwise.
+ */
+static int	script_line(script_t *script, const char *line, size_t len)
+{
+	script_cmd_t	*cmd;
+	int				count = 0;
+
+	if (len && line[len - 1] == '\r')
+		len--;
+	cmd = tokenize(script, line, len);
+	while (cmd->tokens[count])
+		count++;
+	if (count == 0 || cmd->tokens[0][0] == '#')
+		return (1);
+	if (strcmp(cmd->tokens[0], "exit") == 0)
+		return (0);
+	args_init(&cmd->args);
+	cmd->output.len = 0;
+	cmd->args.capture = &cmd->output;
+	cmd->script = script;
+	cmd->done = 0;
+	cmd->status = 0;
+	if (prepare_command(script, cmd, count))
+	{
+		cmd->status = 1;
+		cmd->done = 1;
+		script->tail++;
+	}
+	else if (execute_runs_alone(&cmd->args))
+		run_alone(script, cmd);
+	else
+	{
+		script->tail++;
+		engine_submit(run_command, NULL, cmd);
+	}
+	write_done(script, 0);
+	return (1);
+}
+
+/**
+ * Reads the script line by line through a single buffer: each line is
+ * handled where it was read, and only a partial last line is moved.
+ *
+ * @param script The script.
+ * @param fd The descriptor of the script.
+ * @return 0 on success, 1 on a read error.
+ */
+static int	read_script(script_t *script, int fd)
+{
+	size_t	capacity = SCRIPT_CHUNK;
+	size_t	kept = 0;
+	ssize_t	bytes_read = 0;
+	char	*buffer = malloc(capacity);
+	int		running = 1;
+
+	if (!buffer)
+		print_error_and_exit("malloc() failed");
+	while (running && ((bytes_read = read(fd, buffer + kept, capacity - kept)) > 0
+		|| (bytes_read == -1 && errno == EINTR)))
+	{
+		char	*pos = buffer;
+		char	*end = buffer + kept + (bytes_read > 0 ? bytes_read : 0);
+		char	*newline;
+
+		while (running && (newline = memchr(pos, '\n', end - pos)))
+		{
+			running = script_line(script, pos, newline - pos);
+			pos = newline + 1;
+		}
+		kept = end - pos;
+		memmove(buffer, pos, kept);
+		if (kept == capacity && !(buffer = realloc(buffer, capacity *= 2)))
+			print_error_and_exit("realloc() failed");
+	}
+	if (bytes_read == -1)
+		perror("ft_ssl: read() failed");
+	if (running && kept)
+		script_line(script, buffer, kept);
+	free(buffer);
+	return (bytes_read == -1);
+}
+
+/**
+ * Runs a script of interactive-mode commands ("execute ..." and "exit").
+ * Usage: ft_ssl --script FILE|-
+ * Independent commands are hashed on the worker pool while the reader moves
+ * on, and their outputs are captured and written in script order, several
+ * per writev(). Blank lines and lines starting with '#' are ignored.
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "--script".
+ * @return 0 if every command succeeded, 1 otherwise.
+ */
+int	script_command(int ac, char **av)
+{
+	script_t	*script;
+	int			fd = STDIN_FILENO;
+	int			ret;
+
+	if (ac != 3)
+		print_error_and_exit("usage: ft_ssl --script FILE|-");
+	if (strcmp(av[2], "-") != 0 && (fd = open(av[2], O_RDONLY)) == -1)
+	{
+		fprintf(stderr, "ft_ssl: %s: %s\n", av[2], strerror(errno));
+		return (1);
+	}
+	if (!(script = calloc(1, sizeof(script_t))))
+		print_error_and_exit("malloc() failed");
+	pthread_mutex_init(&script->lock, NULL);
+	pthread_cond_init(&script->changed, NULL);
+	script->from_stdin = (fd == STDIN_FILENO);
+	engine_start(0);
+	ret = read_script(script, fd);
+	engine_finish();
+	drain(script);
+	if (fd != STDIN_FILENO)
+		close(fd);
+	ret |= script->status;
+	for (int i = 0; i < SCRIPT_WINDOW; i++)
+	{
+		free(script->window[i].output.data);
+		free(script->window[i].line);
+		free(script->window[i].tokens);
+	}
+	pthread_mutex_destroy(&script->lock);
+	pthread_cond_destroy(&script->changed);
+	free(script);
+	return (ret);
+}
@@ -0,0 +1,947 @@
+#define _GNU_SOURCE
+#include "../includes/ft_ssl.h"
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/**
+ * Inline payloads up to this size are hashed on the event loop itself:
+ * handing them to a worker would cost more than hashing them.
+ */
+#define SERVE_INLINE_MAX 4096
+
+/**
+ * Largest inline payload accepted by a "data" request.
+ */
+#define SERVE_DATA_MAX (64 << 20)
+
+/**
+ * Number of requests of a connection waiting for their response, beyond
+ * which the connection is no longer read until responses are flushed.
+ */
+#define SERVE_MAX_INFLIGHT 1024
+
+/**
+ * Pooled buffers above this size are released instead of being kept.
+ */
+#define SERVE_POOL_KEEP (1 << 20)
+
+/**
+ * Longest request line.
+ */
+#define SERVE_LINE_MAX 4096
+
+/**
+ * Size of the buffer used by workers to stream files.
+ */
+#define SERVE_READ_CHUNK 65536
+
+/**
+ * Longest response line: "OK " and a 64-byte digest in hex, or an error.
+ */
+#define SERVE_RESPONSE_MAX 192
+
+/**
+ * A hash request, queued on its connection in arrival order.
+ * Requests are recycled through a free list, keeping their data buffer and,
+ * for "execute" requests, their request, tokens and captured output.
+ * A job the worker queue had no room for waits on the backlog of the daemon
+ * ('job', 'path' and 'backlog_next').
+ */
+typedef struct	serve_request_s
+{
+	struct serve_request_s	*next;
+	const hash_algo_t		*algo;
+	uint8_t					*data;
+	size_t					len;
+	size_t					capacity;
+	int						done;
+	char					response[SERVE_RESPONSE_MAX];
+	size_t					response_len;
+	args_t					*args;
+	char					**tokens;
+	output_buffer_t			output;
+	job_function_t			job;
+	char					*path;
+	struct serve_request_s	*backlog_next;
+}				serve_request_t;
+
+/**
+ * A client connection.
+ * Only the event loop touches it; workers only fill in their request and
+ * set its 'done' flag.
+ */
+typedef struct	serve_conn_s
+{
+	struct serve_conn_s	*next;
+	int					fd;
+	char				*in;
+	size_t				in_len;
+	size_t				in_cap;
+	char				*out;
+	size_t				out_len;
+	size_t				out_cap;
+	serve_request_t		*head;
+	serve_request_t		*tail;
+	size_t				inflight;
+	int					closing;
+	int					eof;
+	uint32_t			events;
+	int					passed_fd;
+	size_t				passed_fd_at;
+	shm_session_t		*session;
+}				serve_conn_t;
+
+/**
+ * State of the daemon.
+ */
+typedef struct	serve_s
+{
+	int					epoll_fd;
+	int					listen_fd;
+	int					event_fd;
+	int					signal_fd;
+	serve_conn_t		*conns;
+	serve_request_t		*free_requests;
+	serve_request_t		*backlog_head;
+	serve_request_t		*backlog_tail;
+}				serve_t;
+
+static serve_t	serve;
+
+/**
+ * Formats the response of a request, from a digest or an error message.
+ *
+ * @param req The request.
+ * @param digest The digest, or NULL on error.
+ * @param error The error message when 'digest' is NULL.
+ */
+static void	set_response(serve_request_t *req, const uint8_t *digest, const char *error)
+{
+	size_t	len = 0;
+
+	if (!digest)
+	{
+		len = snprintf(req->response, SERVE_RESPONSE_MAX, "ERR %s\n", error);
+		if (len >= SERVE_RESPONSE_MAX)
+		{
+			len = SERVE_RESPONSE_MAX - 1;
+			req->response[len - 1] = '\n';
+		}
+		req->response_len = len;
+		return;
+	}
+	memcpy(req->response, "OK ", 3);
+	len = 3;
+	for (size_t i = 0; i < req->algo->digest_size; i++)
+	{
+		req->response[len++] = "0123456789abcdef"[digest[i] >> 4];
+		req->response[len++] = "0123456789abcdef"[digest[i] & 15];
+	}
+	req->response[len++] = '\n';
+	req->response_len = len;
+}
+
+/**
+ * Marks a request as answered and wakes the event loop.
+ *
+ * @param req The request.
+ */
+static void	complete_request(serve_request_t *req)
+{
+	uint64_t	one = 1;
+
+	__atomic_store_n(&req->done, 1, __ATOMIC_RELEASE);
+	if (write(serve.event_fd, &one, sizeof(one)) == -1 && errno != EAGAIN)
+		perror("ft_ssl: serve: write() failed");
+}
+
+/**
+ * Worker job hashing a file request, or an inline payload too large to be
+ * hashed on the event loop. Files are streamed through a stack buffer, so a
+ * worker never allocates; errors are returned to the client, not printed.
+ *
+ * @param path The path of the file (owned by the job), or NULL for inline data.
+ * @param data Pointer to the serve_request_t.
+ */
+static void	serve_job(char *path, void *data)
+{
+	serve_request_t	*req = data;
+	uint8_t			digest[MAX_DIGEST_SIZE];
+
+	if (!path)
+	{
+		req->algo->digest(req->data, req->len, digest);
+		set_response(req, digest, NULL);
+		complete_request(req);
+		return;
+	}
+
+	uint8_t		buffer[SERVE_READ_CHUNK];
+	hash_ctx_t	ctx;
+	ssize_t		bytes_read;
+	int			fd = open(path, O_RDONLY);
+
+	if (fd == -1)
+		set_response(req, NULL, strerror(errno));
+	else
+	{
+		req->algo->init(&ctx);
+		while ((bytes_read = read(fd, buffer, sizeof(buffer))) > 0
+			|| (bytes_read == -1 && errno == EINTR))
+			if (bytes_read > 0)
+				req->algo->update(&ctx, buffer, bytes_read);
+		if (bytes_read == -1)
+			set_response(req, NULL, strerror(errno));
+		else
+		{
+			req->algo->final(&ctx, digest);
+			set_response(req, digest, NULL);
+		}
+		close(fd);
+	}
+	free(path);
+	complete_request(req);
+}
+
+/**
+ * Worker job running an "execute" request through the command path of
+ * interactive mode, its output captured in the request.
+ *
+ * @param path Unused.
+ * @param data Pointer to the serve_request_t.
+ */
+static void	serve_execute_job(char *path, void *data)
+{
+	serve_request_t	*req = data;
+	int				status = ft_hash(req->args);
+
+	(void)path;
+	req->response_len = snprintf(req->response, SERVE_RESPONSE_MAX, "EXEC %d %zu\n", status, req->output.len);
+	complete_request(req);
+}
+
+/**
+ * Hands a job to the worker pool without blocking the event loop: when the
+ * queue is full, or older jobs are still waiting, the request joins the
+ * backlog, which is moved to the pool as workers complete jobs.
+ *
+ * @param req The request.
+ * @param job The job function.
+ * @param path The path given to the job (owned by it), or NULL.
+ */
+static void	submit_job(serve_request_t *req, job_function_t job, char *path)
+{
+	if (!serve.backlog_head && engine_try_submit(job, path, req) == 0)
+		return;
+	req->job = job;
+	req->path = path;
+	req->backlog_next = NULL;
+	if (serve.backlog_tail)
+		serve.backlog_tail->backlog_next = req;
+	else
+		serve.backlog_head = req;
+	serve.backlog_tail = req;
+}
+
+/**
+ * Moves the backlog to the worker pool, as far as its queue has room.
+ */
+static void	drain_backlog(void)
+{
+	while (serve.backlog_head
+		&& engine_try_submit(serve.backlog_head->job, serve.backlog_head->path, serve.backlog_head) == 0)
+	{
+		serve.backlog_head = serve.backlog_head->backlog_next;
+		if (!serve.backlog_head)
+			serve.backlog_tail = NULL;
+	}
+}
+
+/**
+ * Takes a request from the pool, or allocates one.
+ *
+ * @param conn The connection the request belongs to; it is queued at its tail.
+ * @return The request.
+ */
+static serve_request_t	*new_request(serve_conn_t *conn)
+{
+	serve_request_t	*req = serve.free_requests;
+
+	if (req)
+		serve.free_requests = req->next;
+	else if (!(req = calloc(1, sizeof(serve_request_t))))
+		print_error_and_exit("calloc() failed");
+	req->next = NULL;
+	req->done = 0;
+	req->len = 0;
+	req->output.len = 0;
+	if (conn->tail)
+		conn->tail->next = req;
+	else
+		conn->head = req;
+	conn->tail = req;
+	conn->inflight++;
+	return (req);
+}
+
+/**
+ * Returns a request to the pool.
+ *
+ * @param req The request.
+ */
+static void	release_request(serve_request_t *req)
+{
+	if (req->capacity > SERVE_POOL_KEEP)
+	{
+		free(req->data);
+		req->data = NULL;
+		req->capacity = 0;
+	}
+	if (req->output.capacity > SERVE_POOL_KEEP)
+	{
+		free(req->output.data);
+		req->output.data = NULL;
+		req->output.capacity = 0;
+	}
+	req->next = serve.free_requests;
+	serve.free_requests = req;
+}
+
+/**
+ * Grows a buffer of a connection to at least 'size' bytes.
+ *
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int	reserve_buffer(char **buffer, size_t *capacity, size_t size)
+{
+	size_t	new_capacity = *capacity ? *capacity : 4096;
+	char	*grown;
+
+	if (size <= *capacity)
+		return (0);
+	while (new_capacity < size)
+		new_capacity *= 2;
+	if (!(grown = realloc(*buffer, new_capacity)))
+		return (-1);
+	*buffer = grown;
+	*capacity = new_capacity;
+	return (0);
+}
+
+/**
+ * Updates the events the event loop waits for on a connection: input while
+ * it accepts more requests, output while responses are pending.
+ *
+ * @param conn The connection.
+ */
+static void	update_events(serve_conn_t *conn)
+{
+	struct epoll_event	event = {0};
+
+	event.events = (conn->out_len ? EPOLLOUT : 0)
+		| (!conn->closing && !conn->eof && conn->inflight < SERVE_MAX_INFLIGHT ? EPOLLIN : 0);
+	if (event.events == conn->events)
+		return;
+	event.data.ptr = conn;
+	epoll_ctl(serve.epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+	conn->events = event.events;
+}
+
+/**
+ * Closes the socket of a connection and ends its shared-memory session.
+ * The connection itself is released by reap_conns(), once the workers are
+ * done with its requests.
+ *
+ * @param conn The connection.
+ */
+static void	close_conn(serve_conn_t *conn)
+{
+	conn->closing = 1;
+	if (conn->fd == -1)
+		return;
+	epoll_ctl(serve.epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+	close(conn->fd);
+	conn->fd = -1;
+	if (conn->passed_fd != -1)
+		close(conn->passed_fd);
+	if (conn->session)
+		shm_detach(conn->session);
+	conn->session = NULL;
+}
+
+/**
+ * Releases the closed connections whose requests have all completed.
+ * Runs after each batch of events, so that no event refers to a released
+ * connection.
+ */
+static void	reap_conns(void)
+{
+	serve_conn_t	**link = &serve.conns;
+
+	while (*link)
+	{
+		serve_conn_t	*conn = *link;
+
+		while (conn->fd == -1 && conn->head && __atomic_load_n(&conn->head->done, __ATOMIC_ACQUIRE))
+		{
+			serve_request_t	*req = conn->head;
+
+			conn->head = req->next;
+			release_request(req);
+		}
+		if (conn->fd != -1 || conn->head)
+		{
+			link = &conn->next;
+			continue;
+		}
+		*link = conn->next;
+		free(conn->in);
+		free(conn->out);
+		free(conn);
+	}
+}
+
+/**
+ * Handles a complete "data" request whose payload is available.
+ *
+ * @param conn The connection.
+ * @param algo The algorithm.
+ * @param payload The payload, in the input buffer of the connection.
+ * @param len The length of the payload.
+ */
+static void	request_data(serve_conn_t *conn, const hash_algo_t *algo, const uint8_t *payload, size_t len)
+{
+	serve_request_t	*req = new_request(conn);
+	uint8_t			digest[MAX_DIGEST_SIZE];
+
+	req->algo = algo;
+	if (len <= SERVE_INLINE_MAX)
+	{
+		algo->digest(payload, len, digest);
+		set_response(req, digest, NULL);
+		req->done = 1;
+		return;
+	}
+	if (reserve_buffer((char **)&req->data, &req->capacity, len) == -1)
+	{
+		set_response(req, NULL, "out of memory");
+		req->done = 1;
+		return;
+	}
+	memcpy(req->data, payload, len);
+	req->len = len;
+	submit_job(req, serve_job, NULL);
+}
+
+/**
+ * Handles an "execute" request: the line is checked and parsed by the
+ * command path of interactive mode into a request of its own, whose output
+ * is captured and sent back as "EXEC <status> <length>" followed by that
+ * many bytes. Commands that need the worker pool themselves or stdin
+ * (-R, --files-from, --disk-order, -c, --per-line, --tar, --batch, -p) are
+ * refused.
+ *
+ * @param conn The connection.
+ * @param line The request line, NUL-terminated.
+ */
+static void	request_execute(serve_conn_t *conn, const char *line)
+{
+	serve_request_t	*req = new_request(conn);
+	size_t			len = strlen(line);
+	int				count = 0;
+
+	if ((!req->args && !(req->args = malloc(sizeof(args_t))))
+		|| (!req->tokens && !(req->tokens = malloc((SERVE_LINE_MAX / 2 + 2) * sizeof(char *))))
+		|| reserve_buffer((char **)&req->data, &req->capacity, len + 1) == -1)
+	{
+		set_response(req, NULL, "out of memory");
+		req->done = 1;
+		return;
+	}
+	memcpy(req->data, line, len + 1);
+	for (char *pos = (char *)req->data; *pos;)
+	{
+		while (*pos == ' ' || *pos == '\t')
+			*pos++ = '\0';
+		if (!*pos)
+			break;
+		req->tokens[count++] = pos;
+		while (*pos && *pos != ' ' && *pos != '\t')
+			pos++;
+	}
+	req->tokens[count] = NULL;
+	args_init(req->args);
+	req->args->capture = &req->output;
+	if (!execute_prepare(req->args, req->tokens, count, "serve"))
+	{
+		if (!execute_runs_alone(req->args))
+		{
+			submit_job(req, serve_execute_job, NULL);
+			return;
+		}
+		print_request_error(req->args, "-R, --files-from, --disk-order, -c, --per-line, --tar, --batch and -p are not available in serve mode.");
+	}
+	req->response_len = snprintf(req->response, SERVE_RESPONSE_MAX, "EXEC 1 %zu\n", req->output.len);
+	req->done = 1;
+}
+
+/**
+ * Handles a "shm" request: attaches the memfd received with it and starts
+ * the session thread. The response only acknowledges the session; digests
+ * are then posted to the completion ring.
+ *
+ * @param conn The connection.
+ */
+static void	request_shm(serve_conn_t *conn)
+{
+	serve_request_t	*req = new_request(conn);
+	const char		*error = "no memfd received with the request";
+
+	req->done = 1;
+	if (conn->session)
+		error = "a shared memory session is already attached";
+	else if (conn->passed_fd != -1 && conn->passed_fd_at == 0)
+	{
+		if ((conn->session = shm_attach(conn->passed_fd, &error)))
+		{
+			conn->passed_fd = -1;
+			memcpy(req->response, "OK shm\n", 7);
+			req->response_len = 7;
+			return;
+		}
+		close(conn->passed_fd);
+		conn->passed_fd = -1;
+	}
+	set_response(req, NULL, error);
+}
+
+/**
+ * Parses one request at the start of the input buffer of a connection.
+ * The protocol is line-based, like interactive mode:
+ *   file ALGO PATH\n        hash the file at PATH
+ *   data ALGO LEN\n<bytes>  hash LEN bytes following the line
+ *   execute ALGO ARGS...\n  run a command of interactive mode, answered by
+ *                          "EXEC <status> <length>\n" and its output
+ *   shm\n                   start a shared-memory session (see ft_shm.h) on
+ *                          the memfd passed with SCM_RIGHTS
+ *   quit\n                  close once every response has been sent
+ * Every other request is answered, in order, by "OK <hex digest>" or
+ * "ERR <message>".
+ *
+ * @param conn The connection.
+ * @return The number of bytes consumed, 0 if the request is incomplete,
+ *   or -1 if the connection must be closed.
+ */
+static ssize_t	parse_request(serve_conn_t *conn)
+{
+	char	*end = memchr(conn->in, '\n', conn->in_len);
+	char	line[SERVE_LINE_MAX + 1];
+	char	*words[3] = {NULL, NULL, NULL};
+	size_t	header;
+	int		command;
+
+	if (!end)
+		return (conn->in_len > SERVE_LINE_MAX ? -1 : 0);
+	header = end - conn->in + 1;
+	if (header > SERVE_LINE_MAX)
+		return (-1);
+	memcpy(line, conn->in, header - 1);
+	line[header - 1] = '\0';
+	if (header > 1 && line[header - 2] == '\r')
+		line[header - 2] = '\0';
+	if (strncmp(line, "execute", 7) == 0 && (line[7] == ' ' || line[7] == '\t' || line[7] == '\0'))
+	{
+		request_execute(conn, line);
+		return (header);
+	}
+	words[0] = strtok(line, " ");
+	words[1] = strtok(NULL, " ");
+	words[2] = strtok(NULL, "");
+	if (words[0] && strcmp(words[0], "quit") == 0)
+	{
+		conn->closing = 1;
+		return (header);
+	}
+	if (words[0] && strcmp(words[0], "shm") == 0)
+	{
+		request_shm(conn);
+		return (header);
+	}
+	if (!words[2] || (strcmp(words[0], "file") != 0 && strcmp(words[0], "data") != 0))
+	{
+		set_response(new_request(conn), NULL, "usage: file ALGO PATH | data ALGO LEN | execute ALGO ARGS... | shm | quit");
+		conn->tail->done = 1;
+		return (header);
+	}
+	if (!(command = find_algo(words[1])))
+	{
+		set_response(new_request(conn), NULL, "invalid algorithm");
+		conn->tail->done = 1;
+		return (strcmp(words[0], "data") == 0 ? -1 : (ssize_t)header);
+	}
+	if (strcmp(words[0], "file") == 0)
+	{
+		serve_request_t	*req = new_request(conn);
+		char			*path = strdup(words[2]);
+
+		req->algo = get_algo(command);
+		if (!path)
+		{
+			set_response(req, NULL, "out of memory");
+			req->done = 1;
+		}
+		else
+			submit_job(req, serve_job, path);
+		return (header);
+	}
+	size_t	len = strtoul(words[2], NULL, 10);
+	if (len > SERVE_DATA_MAX)
+	{
+		set_response(new_request(conn), NULL, "payload too large");
+		conn->tail->done = 1;
+		return (-1);
+	}
+	if (conn->in_len - header < len)
+		return (0);
+	request_data(conn, get_algo(command), (uint8_t *)conn->in + header, len);
+	return (header + len);
+}
+
+/**
+ * Dispatches the complete requests waiting in the input buffer of a
+ * connection, as long as it has room for more requests in flight.
+ * Once the client has shut down its side and every complete request is
+ * dispatched, an incomplete one left over (a line without its newline, or a
+ * "data" payload cut short) is answered with an error and the connection
+ * closes after its responses.
+ *
+ * @param conn The connection.
+ */
+static void	dispatch_requests(serve_conn_t *conn)
+{
+	ssize_t	consumed = 0;
+
+	while (!conn->closing && conn->inflight < SERVE_MAX_INFLIGHT && conn->in_len
+		&& (consumed = parse_request(conn)) > 0)
+	{
+		memmove(conn->in, conn->in + consumed, conn->in_len - consumed);
+		conn->in_len -= consumed;
+		conn->passed_fd_at -= conn->passed_fd_at < (size_t)consumed ? conn->passed_fd_at : (size_t)consumed;
+	}
+	if (consumed == -1)
+	{
+		conn->in_len = 0;
+		conn->closing = 1;
+	}
+	else if (conn->eof && !conn->closing && conn->inflight < SERVE_MAX_INFLIGHT)
+	{
+		if (conn->in_len)
+		{
+			set_response(new_request(conn), NULL, "truncated request");
+			conn->tail->done = 1;
+			conn->in_len = 0;
+		}
+		conn->closing = 1;
+	}
+}
+
+/**
+ * Moves the responses of the completed requests at the head of a connection
+ * queue to its output buffer, and writes as much of it as the socket takes.
+ * Responses are sent in request order, whatever the order of completion.
+ *
+ * Requests left waiting in the input buffer by the in-flight limit are
+ * dispatched as soon as there is room again.
+ *
+ * @param conn The connection.
+ */
+static void	flush_conn(serve_conn_t *conn)
+{
+	if (conn->fd == -1)
+		return;
+	if ((conn->in_len || conn->eof) && !conn->closing && conn->inflight < SERVE_MAX_INFLIGHT)
+		dispatch_requests(conn);
+	while (conn->head && __atomic_load_n(&conn->head->done, __ATOMIC_ACQUIRE))
+	{
+		serve_request_t	*req = conn->head;
+
+		if (reserve_buffer(&conn->out, &conn->out_cap, conn->out_len + req->response_len + req->output.len) == -1)
+		{
+			close_conn(conn);
+			return;
+		}
+		memcpy(conn->out + conn->out_len, req->response, req->response_len);
+		conn->out_len += req->response_len;
+		if (req->output.len)
+			memcpy(conn->out + conn->out_len, req->output.data, req->output.len);
+		conn->out_len += req->output.len;
+		conn->head = req->next;
+		if (!conn->head)
+			conn->tail = NULL;
+		conn->inflight--;
+		release_request(req);
+	}
+	if (conn->out_len)
+	{
+		ssize_t	sent = send(conn->fd, conn->out, conn->out_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+		if (sent == -1 && errno != EAGAIN && errno != EINTR)
+		{
+			close_conn(conn);
+			return;
+		}
+		if (sent > 0)
+		{
+			memmove(conn->out, conn->out + sent, conn->out_len - sent);
+			conn->out_len -= sent;
+		}
+	}
+	if (conn->closing && !conn->head && !conn->out_len)
+		close_conn(conn);
+	else
+		update_events(conn);
+}
+
+/**
+ * Receives bytes from a connection, along with a descriptor passed with
+ * SCM_RIGHTS (for "shm" requests), which replaces any unused previous one.
+ * The descriptor came with the first request starting at or after the
+ * received bytes, so their position in the input buffer is kept.
+ *
+ * @param conn The connection.
+ * @return The number of bytes received, as recvmsg().
+ */
+static ssize_t	receive(serve_conn_t *conn)
+{
+	char			control[CMSG_SPACE(sizeof(int))];
+	struct iovec	iov = {conn->in + conn->in_len, conn->in_cap - conn->in_len};
+	struct msghdr	msg = {0};
+	struct cmsghdr	*cmsg;
+	ssize_t			bytes_read;
+
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	bytes_read = recvmsg(conn->fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+	for (cmsg = CMSG_FIRSTHDR(&msg); bytes_read > 0 && cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+	{
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+		{
+			if (conn->passed_fd != -1)
+				close(conn->passed_fd);
+			memcpy(&conn->passed_fd, CMSG_DATA(cmsg), sizeof(int));
+			conn->passed_fd_at = conn->in_len;
+		}
+	}
+	return (bytes_read);
+}
+
+/**
+ * Reads from a connection and dispatches every complete request.
+ * End of input (the client shut down its side) still lets the pending
+ * responses be sent.
+ *
+ * @param conn The connection.
+ */
+static void	read_conn(serve_conn_t *conn)
+{
+	ssize_t	bytes_read;
+
+	if (reserve_buffer(&conn->in, &conn->in_cap, conn->in_len + SERVE_READ_CHUNK) == -1)
+	{
+		close_conn(conn);
+		return;
+	}
+	bytes_read = receive(conn);
+	if (bytes_read == 0)
+		conn->eof = 1;
+	else if (bytes_read == -1 && errno != EAGAIN && errno != EINTR)
+		conn->closing = 1;
+	if (bytes_read > 0)
+		conn->in_len += bytes_read;
+	dispatch_requests(conn);
+	flush_conn(conn);
+}
+
+/**
+ * Accepts the pending connections of the listening socket.
+ */
+static void	accept_conns(void)
+{
+	int	fd;
+
+	while ((fd = accept4(serve.listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+	{
+		serve_conn_t		*conn = calloc(1, sizeof(serve_conn_t));
+		struct epoll_event	event = {0};
+
+		if (!conn)
+		{
+			close(fd);
+			continue;
+		}
+		conn->fd = fd;
+		conn->passed_fd = -1;
+		conn->events = EPOLLIN;
+		event.events = EPOLLIN;
+		event.data.ptr = conn;
+		epoll_ctl(serve.epoll_fd, EPOLL_CTL_ADD, fd, &event);
+		conn->next = serve.conns;
+		serve.conns = conn;
+	}
+}
+
+/**
+ * Registers a file descriptor of the daemon itself on the event loop.
+ * Its data is set to the fd, which cannot collide with connection pointers.
+ */
+static void	watch_fd(int fd)
+{
+	struct epoll_event	event = {0};
+
+	event.events = EPOLLIN;
+	event.data.u64 = fd;
+	if (epoll_ctl(serve.epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+		print_error_and_exit("epoll_ctl() failed");
+}
+
+/**
+ * Creates the listening socket. A stale socket left by a previous daemon is
+ * replaced; any other existing file is an error.
+ *
+ * @param path The path of the socket.
+ */
+static void	listen_socket(const char *path)
+{
+	struct sockaddr_un	addr = {0};
+	struct stat			st;
+
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path))
+		print_error_and_exit("socket path too long.");
+	strcpy(addr.sun_path, path);
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(path);
+	serve.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (serve.listen_fd == -1
+		|| bind(serve.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1
+		|| listen(serve.listen_fd, SOMAXCONN) == -1)
+	{
+		fprintf(stderr, "ft_ssl: serve: %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+}
+
+/**
+ * Runs the event loop until SIGINT or SIGTERM.
+ */
+static void	event_loop(void)
+{
+	struct epoll_event	events[64];
+	uint64_t			counter;
+
+	while (1)
+	{
+		int	count = epoll_wait(serve.epoll_fd, events, 64, -1);
+
+		if (count == -1 && errno == EINTR)
+			continue;
+		if (count == -1)
+			print_error_and_exit("epoll_wait() failed");
+		for (int i = 0; i < count; i++)
+		{
+			uint64_t	key = events[i].data.u64;
+
+			if (key == (uint64_t)serve.signal_fd)
+				return;
+			else if (key == (uint64_t)serve.listen_fd)
+				accept_conns();
+			else if (key == (uint64_t)serve.event_fd)
+			{
+				if (read(serve.event_fd, &counter, sizeof(counter)) == -1 && errno != EAGAIN)
+					perror("ft_ssl: serve: read() failed");
+				drain_backlog();
+				for (serve_conn_t *conn = serve.conns; conn; conn = conn->next)
+					if (conn->head)
+						flush_conn(conn);
+			}
+			else
+			{
+				serve_conn_t	*conn = events[i].data.ptr;
+
+				if (conn->fd == -1)
+					continue;
+				if (events[i].events & (EPOLLHUP | EPOLLERR))
+					close_conn(conn);
+				else if (events[i].events & EPOLLIN)
+					read_conn(conn);
+				else
+					flush_conn(conn);
+			}
+		}
+		reap_conns();
+	}
+}
+
+/**
+ * Runs a hashing daemon on a Unix domain socket.
+ * Usage: ft_ssl serve --socket PATH
+ * Clients send pipelined requests (see parse_request()) and get one response
+ * line per request, in order. A single epoll loop handles every connection;
+ * small inline payloads are hashed on the loop, files and large payloads on
+ * the worker pool, which stays warm for the life of the daemon. Requests and
+ * buffers are pooled. SIGINT or SIGTERM stops the daemon and removes the socket.
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "serve".
+ * @return 0 when stopped by a signal.
+ */
+int	serve_command(int ac, char **av)
+{
+	sigset_t	signals;
+
+	if (ac != 4 || strcmp(av[2], "--socket") != 0)
+		print_error_and_exit("usage: ft_ssl serve --socket PATH");
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigprocmask(SIG_BLOCK, &signals, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	listen_socket(av[3]);
+	serve.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	serve.event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	serve.signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (serve.epoll_fd == -1 || serve.event_fd == -1 || serve.signal_fd == -1)
+		print_error_and_exit("serve: cannot create the event loop.");
+	watch_fd(serve.listen_fd);
+	watch_fd(serve.event_fd);
+	watch_fd(serve.signal_fd);
+	engine_start(0);
+	fprintf(stderr, "ft_ssl: serve: listening on %s\n", av[3]);
+
+	event_loop();
+
+	close(serve.listen_fd);
+	unlink(av[3]);
+	for (serve_request_t *req = serve.backlog_head; req; req = req->backlog_next)
+		engine_submit(req->job, req->path, req);
+	engine_finish();
+	while (serve.conns)
+	{
+		serve_conn_t	*conn = serve.conns;
+
+		serve.conns = conn->next;
+		close_conn(conn);
+		free(conn->in);
+		free(conn->out);
+		free(conn);
+	}
+	return (0);
+}
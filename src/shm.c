@@ -0,0 +1,302 @@
+#define _GNU_SOURCE
+#include "../includes/ft_ssl.h"
+#include "../includes/ft_shm.h"
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+/**
+ * Number of submissions hashed together, so that short ones share the
+ * multi-lane kernels.
+ */
+#define SHM_BATCH 256
+
+/**
+ * Number of empty polls of the submission ring before the session thread
+ * goes to sleep on the futex (without SHM_BUSY_POLL).
+ */
+#define SHM_SPIN 4096
+
+/**
+ * Longest sleep on the futex, so that a stopped session notices it even if
+ * its wake-up raced with going to sleep.
+ */
+#define SHM_SLEEP_NS 100000000
+
+#if defined(__x86_64__) || defined(__i386__)
+# define CPU_RELAX() __builtin_ia32_pause()
+#else
+# define CPU_RELAX() __asm__ __volatile__("" ::: "memory")
+#endif
+
+/**
+ * A shared-memory session, served by its own thread for as long as the
+ * client keeps its socket open. The ring size and data size are copied
+ * from the header once validated: the client can still write the header.
+ */
+struct	shm_session_s
+{
+	pthread_t		thread;
+	int				fd;
+	uint8_t			*map;
+	size_t			size;
+	shm_header_t	*header;
+	shm_sqe_t		*sq;
+	shm_cqe_t		*cq;
+	uint8_t			*data;
+	uint32_t		entries;
+	uint64_t		data_size;
+	int				stop;
+};
+
+/**
+ * Waits on a futex word of the shared region while it holds 'value'.
+ * The region is shared between processes, so the private futex ops cannot be used.
+ */
+static void	futex_wait(uint32_t *word, uint32_t value)
+{
+	struct timespec	timeout = {0, SHM_SLEEP_NS};
+
+	syscall(SYS_futex, word, FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+/**
+ * Wakes the waiters of a futex word of the shared region.
+ */
+static void	futex_wake(uint32_t *word)
+{
+	syscall(SYS_futex, word, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+/**
+ * Waits until the client publishes submissions past 'head', or the session
+ * is stopped. Polls for a while first, then sleeps on the futex unless the
+ * client asked for busy polling.
+ *
+ * @param session The session.
+ * @param head The next submission to consume.
+ * @return The new submission tail.
+ */
+static uint32_t	wait_submissions(struct shm_session_s *session, uint32_t head)
+{
+	shm_header_t	*header = session->header;
+	uint32_t		tail;
+
+	for (int spin = 0; !__atomic_load_n(&session->stop, __ATOMIC_ACQUIRE); spin++)
+	{
+		if ((tail = __atomic_load_n(&header->sq_tail, __ATOMIC_ACQUIRE)) != head)
+			return (tail);
+		if (spin < SHM_SPIN || (header->flags & SHM_BUSY_POLL))
+		{
+			CPU_RELAX();
+			continue;
+		}
+		__atomic_store_n(&header->server_waiting, 1, __ATOMIC_SEQ_CST);
+		if ((tail = __atomic_load_n(&header->sq_tail, __ATOMIC_SEQ_CST)) == head
+			&& !__atomic_load_n(&session->stop, __ATOMIC_ACQUIRE))
+			futex_wait(&header->sq_tail, head);
+		__atomic_store_n(&header->server_waiting, 0, __ATOMIC_RELAXED);
+		spin = 0;
+	}
+	return (head);
+}
+
+/**
+ * Waits until the completion ring has room for 'count' more entries.
+ * The client is expected to keep at most 'entries' requests outstanding, so
+ * this only spins when it falls behind.
+ *
+ * @param session The session.
+ * @param tail The next completion to produce.
+ * @param count The number of completions to post.
+ * @return 0 when there is room, -1 if the session was stopped.
+ */
+static int	wait_completion_room(struct shm_session_s *session, uint32_t tail, uint32_t count)
+{
+	shm_header_t	*header = session->header;
+
+	while (tail + count - __atomic_load_n(&header->cq_head, __ATOMIC_ACQUIRE) > session->entries)
+	{
+		if (__atomic_load_n(&session->stop, __ATOMIC_ACQUIRE))
+			return (-1);
+		sched_yield();
+	}
+	return (0);
+}
+
+/**
+ * Hashes a batch of submissions in place and fills their completions.
+ * Submissions are copied first, so the client cannot change them between
+ * the bounds check and the hashing. Consecutive submissions with the same
+ * algorithm are hashed together through digest_batch().
+ *
+ * @param session The session.
+ * @param sqes The submissions.
+ * @param cqes The completions.
+ * @param count The number of submissions.
+ */
+static void	hash_submissions(struct shm_session_s *session, const shm_sqe_t *sqes, shm_cqe_t *cqes, uint32_t count)
+{
+	const uint8_t	*msgs[SHM_BATCH];
+	size_t			lens[SHM_BATCH];
+	uint8_t			*digests[SHM_BATCH];
+	uint32_t		run = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const hash_algo_t	*algo = get_algo(sqes[i].algo);
+
+		cqes[i].user_data = sqes[i].user_data;
+		cqes[i].status = 0;
+		cqes[i].digest_size = algo ? algo->digest_size : 0;
+		if (!algo)
+			cqes[i].status = EINVAL;
+		else if (sqes[i].offset > session->data_size
+			|| sqes[i].len > session->data_size - sqes[i].offset)
+			cqes[i].status = ERANGE;
+	}
+	for (uint32_t i = 0; i < count; i = run)
+	{
+		size_t	n = 0;
+
+		for (run = i; run < count && sqes[run].algo == sqes[i].algo; run++)
+		{
+			if (cqes[run].status)
+				continue;
+			msgs[n] = session->data + sqes[run].offset;
+			lens[n] = sqes[run].len;
+			digests[n++] = cqes[run].digest;
+		}
+		if (n)
+			digest_batch(get_algo(sqes[i].algo), msgs, lens, digests, n);
+	}
+}
+
+/**
+ * Main loop of a session thread: consumes the submission ring, hashes the
+ * data where the client wrote it and posts the digests to the completion
+ * ring, waking the client when it sleeps.
+ *
+ * @param data Pointer to the session.
+ * @return Always NULL.
+ */
+static void	*session_loop(void *data)
+{
+	struct shm_session_s	*session = data;
+	shm_header_t			*header = session->header;
+	uint32_t				mask = session->entries - 1;
+	uint32_t				head = header->sq_head;
+	uint32_t				cq_tail = header->cq_tail;
+	shm_sqe_t				sqes[SHM_BATCH];
+	shm_cqe_t				cqes[SHM_BATCH];
+
+	while (!__atomic_load_n(&session->stop, __ATOMIC_ACQUIRE))
+	{
+		uint32_t	tail = wait_submissions(session, head);
+		uint32_t	count = tail - head;
+
+		if (count == 0)
+			continue;
+		if (count > SHM_BATCH)
+			count = SHM_BATCH;
+		for (uint32_t i = 0; i < count; i++)
+			sqes[i] = session->sq[(head + i) & mask];
+		head += count;
+		__atomic_store_n(&header->sq_head, head, __ATOMIC_RELEASE);
+		hash_submissions(session, sqes, cqes, count);
+		if (wait_completion_room(session, cq_tail, count) == -1)
+			break;
+		for (uint32_t i = 0; i < count; i++)
+			session->cq[(cq_tail + i) & mask] = cqes[i];
+		cq_tail += count;
+		__atomic_store_n(&header->cq_tail, cq_tail, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&header->client_waiting, __ATOMIC_SEQ_CST))
+			futex_wake(&header->cq_tail);
+	}
+	return (NULL);
+}
+
+/**
+ * Checks that a region of the mapping is in bounds.
+ */
+static int	in_region(size_t size, uint64_t offset, uint64_t len)
+{
+	return (offset <= size && len <= size - offset && offset % 8 == 0);
+}
+
+/**
+ * Maps the memfd of a client, validates its layout and starts the session
+ * thread. The memfd must be sealed against shrinking, so that the client
+ * cannot make the daemon fault on a truncated mapping.
+ * The client can still write the header while it is being checked, so the
+ * layout is copied once and the session is built from that copy only.
+ *
+ * @param fd The memfd, owned by the session on success.
+ * @param error Receives a message on failure.
+ * @return The session, or NULL on failure.
+ */
+shm_session_t	*shm_attach(int fd, const char **error)
+{
+	struct shm_session_s	*session;
+	struct stat				st;
+	shm_header_t			layout;
+	void					*map;
+	int						seals = fcntl(fd, F_GET_SEALS);
+
+	*error = "invalid shared memory region";
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(shm_header_t))
+		return (NULL);
+	if (seals == -1 || !(seals & F_SEAL_SHRINK))
+	{
+		*error = "shared memory region must be sealed with F_SEAL_SHRINK";
+		return (NULL);
+	}
+	if ((map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		return (NULL);
+	memcpy(&layout, map, sizeof(layout));
+	__asm__ __volatile__("" ::: "memory");
+	if (layout.magic != SHM_MAGIC || layout.version != SHM_VERSION
+		|| layout.entries == 0 || layout.entries > SHM_MAX_ENTRIES
+		|| (layout.entries & (layout.entries - 1))
+		|| !in_region(st.st_size, layout.sq_offset, (uint64_t)layout.entries * sizeof(shm_sqe_t))
+		|| !in_region(st.st_size, layout.cq_offset, (uint64_t)layout.entries * sizeof(shm_cqe_t))
+		|| !in_region(st.st_size, layout.data_offset, layout.data_size)
+		|| !(session = calloc(1, sizeof(struct shm_session_s))))
+	{
+		munmap(map, st.st_size);
+		return (NULL);
+	}
+	session->fd = fd;
+	session->map = map;
+	session->size = st.st_size;
+	session->header = map;
+	session->sq = (shm_sqe_t *)(session->map + layout.sq_offset);
+	session->cq = (shm_cqe_t *)(session->map + layout.cq_offset);
+	session->data = session->map + layout.data_offset;
+	session->entries = layout.entries;
+	session->data_size = layout.data_size;
+	if (pthread_create(&session->thread, NULL, session_loop, session) != 0)
+	{
+		munmap(map, st.st_size);
+		free(session);
+		*error = "cannot start the session thread";
+		return (NULL);
+	}
+	return (session);
+}
+
+/**
+ * Stops a session: wakes its thread, waits for it and unmaps the region.
+ *
+ * @param session The session.
+ */
+void	shm_detach(shm_session_t *session)
+{
+	__atomic_store_n(&session->stop, 1, __ATOMIC_RELEASE);
+	futex_wake(&session->header->sq_tail);
+	pthread_join(session->thread, NULL);
+	munmap(session->map, session->size);
+	close(session->fd);
+	free(session);
+}
@@ -0,0 +1,307 @@
+#define _GNU_SOURCE
+#include "../includes/ft_ssl.h"
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+
+/**
+ * Settings of a store run, shared by the ingest workers.
+ */
+typedef struct	store_s
+{
+	const args_t		*args;
+	const char			*dir;
+	int					dir_fd;
+	int					link;
+	const hash_algo_t	*algo;
+}				store_t;
+
+/**
+ * Writes a whole buffer, retrying on short writes.
+ *
+ * @param fd The destination file descriptor.
+ * @param buffer The bytes to write.
+ * @param size The number of bytes to write.
+ * @return 1 on success, 0 on error.
+ */
+static int	write_all(int fd, const uint8_t *buffer, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t	written = write(fd, buffer, size);
+		if (written <= 0)
+			return (0);
+		buffer += written;
+		size -= written;
+	}
+	return (1);
+}
+
+/**
+ * Reads a file once, feeding every chunk to the hash and, when 'out' is a
+ * valid descriptor, writing it to 'out' as well.
+ *
+ * @param store The store run.
+ * @param src The source file descriptor.
+ * @param out The copy destination, or -1 to only hash.
+ * @param digest Buffer receiving the digest of the file.
+ * @return 1 on success, 0 on error (errno is set).
+ */
+static int	hash_and_copy(const store_t *store, int src, int out, uint8_t *digest)
+{
+	hash_ctx_t	ctx;
+	uint8_t		*buffer = arena_scratch(STORE_CHUNK_SIZE);
+	ssize_t		bytes_read;
+
+	store->algo->init(&ctx);
+	while ((bytes_read = read(src, buffer, STORE_CHUNK_SIZE)) > 0)
+	{
+		store->algo->update(&ctx, buffer, bytes_read);
+		if (out != -1 && !write_all(out, buffer, bytes_read))
+			break;
+	}
+	if (bytes_read != 0)
+		return (0);
+	store->algo->final(&ctx, digest);
+	return (1);
+}
+
+/**
+ * Builds the content address of a digest ("ab/cdef...") and creates its
+ * fan-out directory if needed.
+ *
+ * @param store The store run.
+ * @param digest The raw digest.
+ * @param object Buffer receiving the relative object path.
+ * @return The hexadecimal digest, to be freed by the caller, or NULL on error.
+ */
+static char	*object_path(const store_t *store, const uint8_t *digest, char *object)
+{
+	char	*hex = bytes_to_hex_string((uint8_t *)digest, store->algo->digest_size);
+
+	if (!hex)
+		return (NULL);
+	object[0] = hex[0];
+	object[1] = hex[1];
+	object[2] = '\0';
+	if (mkdirat(store->dir_fd, object, 0755) == -1 && errno != EEXIST)
+	{
+		free(hex);
+		return (NULL);
+	}
+	object[2] = '/';
+	strcpy(object + 3, hex + 2);
+	return (hex);
+}
+
+/**
+ * Ingests a file by hard-linking it into the store.
+ * The file is read once to be hashed; nothing is copied.
+ *
+ * @param store The store run.
+ * @param path The path of the file.
+ * @param src The open file descriptor of the file.
+ * @return The hexadecimal digest on success, NULL on error (errno is set).
+ */
+static char	*store_link(const store_t *store, const char *path, int src)
+{
+	uint8_t	digest[MAX_DIGEST_SIZE];
+	char	object[MAX_DIGEST_SIZE * 2 + 2];
+	char	*hex;
+
+	if (!hash_and_copy(store, src, -1, digest) || !(hex = object_path(store, digest, object)))
+		return (NULL);
+	if (linkat(AT_FDCWD, path, store->dir_fd, object, 0) == -1 && errno != EEXIST)
+	{
+		free(hex);
+		return (NULL);
+	}
+	return (hex);
+}
+
+/**
+ * Ingests a file by copying it into the store.
+ * The data lands in a temporary file of the store directory: it is reflinked
+ * (FICLONE) when the file system allows it, otherwise every chunk read for
+ * hashing is written out at once, so the source is read a single time.
+ * The temporary file is then linked to its content address, unless an object
+ * with the same content already exists.
+ *
+ * @param store The store run.
+ * @param src The open file descriptor of the file.
+ * @return The hexadecimal digest on success, NULL on error (errno is set).
+ */
+static char	*store_copy(const store_t *store, int src)
+{
+	uint8_t	digest[MAX_DIGEST_SIZE];
+	char	object[MAX_DIGEST_SIZE * 2 + 2];
+	char	*tmp_path = malloc(strlen(store->dir) + sizeof("/.ft_ssl-XXXXXX"));
+	char	*hex = NULL;
+	int		tmp;
+	int		saved_errno;
+
+	if (!tmp_path)
+		return (NULL);
+	strcpy(tmp_path, store->dir);
+	strcat(tmp_path, "/.ft_ssl-XXXXXX");
+	if ((tmp = mkstemp(tmp_path)) == -1)
+	{
+		free(tmp_path);
+		return (NULL);
+	}
+	int	cloned = (ioctl(tmp, FICLONE, src) == 0);
+	if (hash_and_copy(store, src, cloned ? -1 : tmp, digest)
+		&& fchmod(tmp, 0444) == 0
+		&& (hex = object_path(store, digest, object))
+		&& linkat(AT_FDCWD, tmp_path, store->dir_fd, object, 0) == -1
+		&& errno != EEXIST)
+	{
+		free(hex);
+		hex = NULL;
+	}
+	saved_errno = errno;
+	close(tmp);
+	unlink(tmp_path);
+	free(tmp_path);
+	errno = saved_errno;
+	return (hex);
+}
+
+/**
+ * Ingests one file into the store on a hashing worker.
+ *
+ * @param path The path of the file, released by this function.
+ * @param data The store run.
+ */
+static void	store_job(char *path, void *data)
+{
+	const store_t	*store = data;
+	char			*hex = NULL;
+	int				src = open(path, O_RDONLY);
+
+	if (src != -1)
+	{
+		posix_fadvise(src, 0, 0, POSIX_FADV_SEQUENTIAL);
+		if (store->link)
+		{
+			hex = store_link(store, path, src);
+			if (!hex && errno == EXDEV && lseek(src, 0, SEEK_SET) == 0)
+				hex = store_copy(store, src);
+		}
+		else
+			hex = store_copy(store, src);
+		close(src);
+	}
+	if (hex)
+		display_hash(store->args, hex, path, 3);
+	else
+		print_error(store->args, path, strerror(errno));
+	free(hex);
+	free(path);
+}
+
+/**
+ * Walker callback streaming each file to the ingest workers.
+ *
+ * @param file The file found by the walker.
+ * @param data The store run.
+ */
+static void	submit_store(walk_entry_t *file, void *data)
+{
+	engine_submit(store_job, file->path, data);
+}
+
+/**
+ * Parses the arguments of the store command.
+ * Usage: ft_ssl store --cas DIR [-a algo] [--link] [-R] [-q] [-r] file...
+ *
+ * @param args The request, receiving the algorithm and flags.
+ * @param store The store run, receiving the directory and --link.
+ * @param ac The argument count.
+ * @param av The argument vector.
+ * @return The index of the first file in 'av'.
+ */
+static int	parse_store_args(args_t *args, store_t *store, int ac, char **av)
+{
+	int	i = 2;
+
+	args->command = 2;
+	while (i < ac && av[i][0] == '-')
+	{
+		if (strcmp(av[i], "--cas") == 0 && i + 1 < ac)
+			store->dir = av[++i];
+		else if (strcmp(av[i], "-a") == 0 && i + 1 < ac)
+		{
+			if (!(args->command = find_algo(av[++i])))
+			{
+				fprintf(stderr, "ft_ssl: Error: '%s' is an invalid algorithm.\n", av[i]);
+				exit(1);
+			}
+		}
+		else if (strcmp(av[i], "--link") == 0)
+			store->link = 1;
+		else if (strcmp(av[i], "-R") == 0)
+			args->recursive = 1;
+		else if (strcmp(av[i], "-q") == 0)
+			args->quiet = 1;
+		else if (strcmp(av[i], "-r") == 0)
+			args->reverse = 1;
+		else
+		{
+			fprintf(stderr, "ft_ssl: Error: '%s' is an invalid flag.\n", av[i]);
+			exit(1);
+		}
+		i++;
+	}
+	if (!store->dir || i >= ac)
+		print_error_and_exit("usage: ft_ssl store --cas DIR [-a md5|sha256|whirlpool] [--link] [-R] [-q] [-r] file...");
+	return (i);
+}
+
+/**
+ * Ingests files into a content-addressed store.
+ * Each file is hashed and placed at DIR/ab/cdef..., named after its digest;
+ * content already present in the store is not stored twice.
+ *
+ * @param ac The argument count.
+ * @param av The argument vector, av[1] being "store".
+ * @return 0 on success, 1 if the store directory cannot be opened.
+ */
+int	store_command(int ac, char **av)
+{
+	store_t	store;
+	args_t	args;
+	int		first;
+
+	args_init(&args);
+	ft_bzero(&store, sizeof(store));
+	first = parse_store_args(&args, &store, ac, av);
+	store.args = &args;
+	store.algo = get_algo(args.command);
+	if (mkdir(store.dir, 0755) == -1 && errno != EEXIST)
+	{
+		print_error(&args, (char *)store.dir, strerror(errno));
+		return (1);
+	}
+	if ((store.dir_fd = open(store.dir, O_RDONLY | O_DIRECTORY)) == -1)
+	{
+		print_error(&args, (char *)store.dir, strerror(errno));
+		return (1);
+	}
+
+	engine_start(0);
+	if (args.recursive)
+		walk_tree(&args, av + first, ac - first, 0, submit_store, &store);
+	else
+	{
+		for (int i = first; i < ac; i++)
+		{
+			char	*path = strdup(av[i]);
+			if (path)
+				engine_submit(store_job, path, &store);
+		}
+	}
+	engine_finish();
+	close(store.dir_fd);
+	return (0);
+}
@@ -0,0 +1,380 @@
+#include "../includes/ft_ssl.h"
+
+/**
+ * Size of a tar block: headers are one block, member data is padded to a
+ * multiple of it.
+ */
+#define TAR_BLOCK 512
+
+/**
+ * Number of bytes read from the archive at a time.
+ */
+#define TAR_CHUNK 65536
+
+/**
+ * Sequential reader over an archive.
+ * Member data is handed to the hash straight from 'buffer', so every byte is
+ * read once and never copied.
+ */
+typedef struct	tar_stream_s
+{
+	const args_t	*args;
+	int				fd;
+	char			*name;
+	uint8_t			buffer[TAR_CHUNK];
+	size_t			pos;
+	size_t			len;
+	int				error;
+}				tar_stream_t;
+
+/**
+ * Attributes of the next member set by pax extended headers ('x') or GNU
+ * long name entries ('L'); they override the ustar header fields.
+ */
+typedef struct	tar_override_s
+{
+	char		*path;
+	uint64_t	size;
+	int			has_size;
+}				tar_override_t;
+
+/**
+ * Consumes bytes from the archive.
+ * The bytes are fed to the hash context when 'ctx' is set, copied to 'dst'
+ * when it is set, and discarded otherwise.
+ *
+ * @param tar The archive.
+ * @param n The number of bytes to consume.
+ * @param ctx The hash context receiving the bytes, or NULL.
+ * @param dst The buffer receiving the bytes, or NULL.
+ * @return 0 on success, 1 if the archive ended first or could not be read
+ * (then recorded in 'error').
+ */
+static int	tar_consume(tar_stream_t *tar, uint64_t n, hash_ctx_t *ctx, uint8_t *dst)
+{
+	const hash_algo_t	*algo = get_algo(tar->args->command);
+
+	while (n > 0)
+	{
+		if (tar->pos == tar->len)
+		{
+			ssize_t	bytes_read = read(tar->fd, tar->buffer, TAR_CHUNK);
+
+			if (bytes_read == -1 && errno == EINTR)
+				continue;
+			if (bytes_read == -1)
+				tar->error = errno;
+			if (bytes_read <= 0)
+				return (1);
+			tar->pos = 0;
+			tar->len = bytes_read;
+		}
+		size_t	take = tar->len - tar->pos;
+		if (take > n)
+			take = n;
+		if (ctx)
+			algo->update(ctx, tar->buffer + tar->pos, take);
+		if (dst)
+		{
+			memcpy(dst, tar->buffer + tar->pos, take);
+			dst += take;
+		}
+		tar->pos += take;
+		n -= take;
+	}
+	return (0);
+}
+
+/**
+ * Tells whether the archive has no bytes left, refilling the buffer if needed.
+ * A read error also ends the archive, and is recorded in 'error'.
+ *
+ * @param tar The archive.
+ * @return 1 at the end of the input or on a read error, 0 otherwise.
+ */
+static int	tar_at_end(tar_stream_t *tar)
+{
+	ssize_t	bytes_read;
+
+	if (tar->pos < tar->len)
+		return (0);
+	while ((bytes_read = read(tar->fd, tar->buffer, TAR_CHUNK)) == -1 && errno == EINTR)
+		;
+	if (bytes_read == -1)
+		tar->error = errno;
+	tar->pos = 0;
+	tar->len = bytes_read > 0 ? bytes_read : 0;
+	return (bytes_read <= 0);
+}
+
+/**
+ * Parses a numeric header field: octal digits, or a big-endian base-256
+ * number when the high bit of the first byte is set (GNU extension for
+ * members of 8 GiB and more).
+ *
+ * @param field The field.
+ * @param len The length of the field.
+ * @return The value.
+ */
+static uint64_t	parse_number(const uint8_t *field, size_t len)
+{
+	uint64_t	value = 0;
+	size_t		i = 0;
+
+	if (field[0] & 0x80)
+	{
+		value = field[0] & 0x7f;
+		for (i = 1; i < len; i++)
+			value = value << 8 | field[i];
+		return (value);
+	}
+	while (i < len && (field[i] == ' ' || field[i] == '\0'))
+		i++;
+	for (; i < len && field[i] >= '0' && field[i] <= '7'; i++)
+		value = value * 8 + (field[i] - '0');
+	return (value);
+}
+
+/**
+ * Verifies the checksum of a header: the sum of its bytes, the checksum
+ * field itself being counted as spaces.
+ *
+ * @param header The header block.
+ * @return 1 if the checksum matches, 0 otherwise.
+ */
+static int	valid_checksum(const uint8_t *header)
+{
+	uint64_t	sum = 0;
+
+	for (int i = 0; i < TAR_BLOCK; i++)
+		sum += (i >= 148 && i < 156) ? ' ' : header[i];
+	return (sum == parse_number(header + 148, 8));
+}
+
+/**
+ * Reads a pax extended header and records the path and size it sets.
+ * Each record is "LENGTH KEY=VALUE\n", LENGTH counting the whole record.
+ *
+ * @param data The content of the extended header.
+ * @param size The size of the content.
+ * @param override The attributes of the next member.
+ */
+static void	parse_pax(char *data, size_t size, tar_override_t *override)
+{
+	size_t	pos = 0;
+
+	while (pos < size)
+	{
+		char	*end;
+		size_t	len = strtoul(data + pos, &end, 10);
+		char	*key = end + 1;
+		char	*value;
+
+		if (len == 0 || *end != ' ' || pos + len > size || data[pos + len - 1] != '\n')
+			return;
+		data[pos + len - 1] = '\0';
+		if ((value = strchr(key, '=')))
+		{
+			*value++ = '\0';
+			if (strcmp(key, "path") == 0)
+			{
+				free(override->path);
+				override->path = strdup(value);
+			}
+			else if (strcmp(key, "size") == 0)
+			{
+				override->size = strtoull(value, NULL, 10);
+				override->has_size = 1;
+			}
+		}
+		pos += len;
+	}
+}
+
+/**
+ * Reads the content of a metadata member (pax header or GNU long name).
+ *
+ * @param tar The archive.
+ * @param size The size of the member.
+ * @return The NUL-terminated content, or NULL if the archive ended first.
+ */
+static char	*read_metadata(tar_stream_t *tar, uint64_t size)
+{
+	char	*data = malloc(size + 1);
+
+	if (!data)
+		print_error_and_exit("malloc() failed");
+	if (tar_consume(tar, size, NULL, (uint8_t *)data))
+	{
+		free(data);
+		return (NULL);
+	}
+	data[size] = '\0';
+	return (data);
+}
+
+/**
+ * Builds the path of a member from its header: "prefix/name" for ustar
+ * headers with a prefix, "name" otherwise.
+ *
+ * @param header The header block.
+ * @return The allocated path.
+ */
+static char	*header_path(const uint8_t *header)
+{
+	char	name[101] = {0};
+	char	prefix[156] = {0};
+	char	*path;
+
+	memcpy(name, header, 100);
+	if (memcmp(header + 257, "ustar", 5) == 0)
+		memcpy(prefix, header + 345, 155);
+	if (!(path = malloc(strlen(prefix) + strlen(name) + 2)))
+		print_error_and_exit("malloc() failed");
+	if (prefix[0])
+		sprintf(path, "%s/%s", prefix, name);
+	else
+		strcpy(path, name);
+	return (path);
+}
+
+/**
+ * Hashes the data of a regular member and displays its digest.
+ *
+ * @param tar The archive.
+ * @param path The path of the member, displayed as its name.
+ * @param size The size of the member.
+ * @return 0 on success, 1 if the archive ended first.
+ */
+static int	hash_member(tar_stream_t *tar, char *path, uint64_t size)
+{
+	const args_t		*args = tar->args;
+	const hash_algo_t	*algo = get_algo(args->command);
+	hash_ctx_t			ctx;
+	uint8_t				digest[MAX_DIGEST_SIZE];
+
+	if (args->prefix_file)
+		ctx = args->midstate;
+	else
+		algo->init(&ctx);
+	if (tar_consume(tar, size, &ctx, NULL))
+		return (1);
+	algo->final(&ctx, digest);
+	display_digest(args, digest, path, 3);
+	return (0);
+}
+
+/**
+ * Walks the members of an archive in a single pass, until the first zero
+ * block or the end of the input.
+ *
+ * @param tar The archive.
+ * @return 0 on success, 1 if the archive is truncated, corrupted or cannot
+ * be read.
+ */
+static int	walk_archive(tar_stream_t *tar)
+{
+	tar_override_t	override = {NULL, 0, 0};
+	uint8_t			header[TAR_BLOCK];
+	int				ret = 0;
+
+	while (!tar_at_end(tar) && !(ret = tar_consume(tar, TAR_BLOCK, NULL, header)))
+	{
+		uint8_t		type = header[156];
+		uint64_t	size;
+		char		*data = NULL;
+
+		if (header[0] == '\0')
+			break;
+		if (!valid_checksum(header))
+		{
+			print_error(tar->args, tar->name, "invalid tar header checksum");
+			free(override.path);
+			return (1);
+		}
+		size = override.has_size ? override.size : parse_number(header + 124, 12);
+		if (type == 'x' || type == 'L')
+		{
+			size = parse_number(header + 124, 12);
+			if (!(data = read_metadata(tar, size)))
+			{
+				ret = 1;
+				break;
+			}
+			if (type == 'x')
+				parse_pax(data, size, &override);
+			else
+			{
+				free(override.path);
+				override.path = strdup(data);
+			}
+			free(data);
+		}
+		else if (type == '0' || type == '\0' || type == '7')
+		{
+			char	*path = override.path ? override.path : header_path(header);
+
+			override.path = NULL;
+			ret = hash_member(tar, path, size);
+			free(path);
+			override.has_size = 0;
+			if (ret)
+				break;
+		}
+		else
+		{
+			if ((ret = tar_consume(tar, size, NULL, NULL)))
+				break;
+			if (type != 'g')
+			{
+				free(override.path);
+				override.path = NULL;
+				override.has_size = 0;
+			}
+		}
+		if ((ret = tar_consume(tar, (TAR_BLOCK - size % TAR_BLOCK) % TAR_BLOCK, NULL, NULL)))
+			break;
+	}
+	if (tar->error)
+		print_error(tar->args, tar->name, strerror(tar->error));
+	else if (ret)
+		print_error(tar->args, tar->name, "unexpected end of archive");
+	free(override.path);
+	return (ret || tar->error);
+}
+
+/**
+ * Hashes every regular member of a tar archive (ustar, pax or GNU) and
+ * displays one digest per member path, without extracting anything.
+ * The archive is read sequentially, in a single pass, so it can come from a
+ * pipe; each member is fed to a fresh context straight from the read buffer.
+ *
+ * @param args The request.
+ * @param path The path of the archive, or "-" for stdin.
+ * @return 0 on success, 1 if the archive could not be read or is invalid.
+ */
+int	hash_tar(const args_t *args, const char *path)
+{
+	tar_stream_t	*tar = malloc(sizeof(tar_stream_t));
+	int				ret;
+
+	if (!tar)
+		print_error_and_exit("malloc() failed");
+	tar->args = args;
+	tar->fd = STDIN_FILENO;
+	tar->name = strcmp(path, "-") == 0 ? "stdin" : (char *)path;
+	tar->pos = 0;
+	tar->len = 0;
+	tar->error = 0;
+	if (strcmp(path, "-") != 0 && (tar->fd = open(path, O_RDONLY)) == -1)
+	{
+		print_error(args, (char *)path, strerror(errno));
+		free(tar);
+		return (1);
+	}
+	ret = walk_archive(tar);
+	if (tar->fd != STDIN_FILENO)
+		close(tar->fd);
+	free(tar);
+	return (ret);
+}
@@ -0,0 +1,241 @@
+#define _GNU_SOURCE
+#include "../includes/ft_ssl.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+/**
+ * Layout of the records returned by the getdents64 system call.
+ */
+struct	linux_dirent64
+{
+	uint64_t		d_ino;
+	int64_t			d_off;
+	unsigned short	d_reclen;
+	unsigned char	d_type;
+	char			d_name[];
+};
+
+/**
+ * Directory waiting to be read by one of the walker threads.
+ */
+typedef struct	walk_dir_s
+{
+	char				*path;
+	struct walk_dir_s	*next;
+}				walk_dir_t;
+
+/**
+ * Shared state of a parallel walk.
+ * 'pending' counts the directories queued or being read; the walk is over
+ * once it drops to zero.
+ */
+typedef struct	walk_s
+{
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+	walk_dir_t		*stack;
+	size_t			pending;
+	int				flags;
+	walk_callback_t	on_file;
+	void			*data;
+	const args_t	*args;
+}				walk_t;
+
+/**
+ * Pushes a directory on the walk stack and wakes up an idle walker.
+ * Ownership of 'path' is transferred to the walk.
+ *
+ * @param walk The walk state.
+ * @param path The path of the directory to read.
+ */
+static void	walk_push(walk_t *walk, char *path)
+{
+	walk_dir_t	*dir = malloc(sizeof(walk_dir_t));
+	if (!dir)
+	{
+		print_error(walk->args, path, strerror(errno));
+		free(path);
+		return;
+	}
+	dir->path = path;
+	pthread_mutex_lock(&walk->lock);
+	dir->next = walk->stack;
+	walk->stack = dir;
+	walk->pending++;
+	pthread_cond_signal(&walk->cond);
+	pthread_mutex_unlock(&walk->lock);
+}
+
+/**
+ * Joins a directory path and an entry name, avoiding a doubled separator.
+ *
+ * @param dir The directory path.
+ * @param name The entry name.
+ * @return A newly allocated path, or NULL on allocation failure.
+ */
+static char	*walk_join(const char *dir, const char *name)
+{
+	size_t	dir_len = strlen(dir);
+	size_t	name_len = strlen(name);
+	char	*path = malloc(dir_len + name_len + 2);
+
+	if (!path)
+		return (NULL);
+	memcpy(path, dir, dir_len);
+	if (dir_len == 0 || dir[dir_len - 1] != '/')
+		path[dir_len++] = '/';
+	memcpy(path + dir_len, name, name_len + 1);
+	return (path);
+}
+
+/**
+ * Reads one directory with getdents64 and dispatches its entries.
+ * Sub-directories are pushed on the walk stack, regular files are handed to
+ * the walk callback. Entries of unknown type (or all files when WALK_STAT is
+ * set) are resolved with statx relative to the directory descriptor.
+ *
+ * @param walk The walk state.
+ * @param path The path of the directory to read.
+ */
+static void	walk_read_dir(walk_t *walk, const char *path)
+{
+	char	buffer[WALK_DENTS_SIZE];
+	long	nread;
+	int		fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (fd == -1)
+	{
+		print_error(walk->args, (char *)path, strerror(errno));
+		return;
+	}
+	while ((nread = syscall(SYS_getdents64, fd, buffer, sizeof(buffer))) > 0)
+	{
+		for (long pos = 0; pos < nread;)
+		{
+			struct linux_dirent64	*entry = (struct linux_dirent64 *)(buffer + pos);
+			unsigned char			type = entry->d_type;
+			walk_entry_t			file = {NULL, 0, entry->d_ino};
+			struct statx			st;
+
+			pos += entry->d_reclen;
+			if (entry->d_name[0] == '.' && (entry->d_name[1] == '\0'
+				|| (entry->d_name[1] == '.' && entry->d_name[2] == '\0')))
+				continue;
+			if (type == DT_UNKNOWN || (type == DT_REG && (walk->flags & WALK_STAT)))
+			{
+				if (statx(fd, entry->d_name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+					STATX_TYPE | STATX_SIZE | STATX_INO, &st) == -1)
+					continue;
+				type = S_ISDIR(st.stx_mode) ? DT_DIR : S_ISREG(st.stx_mode) ? DT_REG : DT_UNKNOWN;
+				file.size = st.stx_size;
+				file.ino = st.stx_ino;
+			}
+			if (type != DT_DIR && type != DT_REG)
+				continue;
+			if (!(file.path = walk_join(path, entry->d_name)))
+			{
+				print_error(walk->args, (char *)path, strerror(errno));
+				continue;
+			}
+			if (type == DT_DIR)
+				walk_push(walk, file.path);
+			else
+				walk->on_file(&file, walk->data);
+		}
+	}
+	if (nread == -1)
+		print_error(walk->args, (char *)path, strerror(errno));
+	close(fd);
+}
+
+/**
+ * Main loop of a walker thread.
+ * Pops directories until the stack is empty and no other walker can refill it.
+ *
+ * @param arg Pointer to the shared walk state.
+ * @return Always NULL.
+ */
+static void	*walk_worker(void *arg)
+{
+	walk_t		*walk = arg;
+	walk_dir_t	*dir;
+
+	while (1)
+	{
+		pthread_mutex_lock(&walk->lock);
+		while (!walk->stack && walk->pending)
+			pthread_cond_wait(&walk->cond, &walk->lock);
+		if (!walk->stack)
+		{
+			pthread_mutex_unlock(&walk->lock);
+			break;
+		}
+		dir = walk->stack;
+		walk->stack = dir->next;
+		pthread_mutex_unlock(&walk->lock);
+
+		walk_read_dir(walk, dir->path);
+		free(dir->path);
+		free(dir);
+
+		pthread_mutex_lock(&walk->lock);
+		if (--walk->pending == 0)
+			pthread_cond_broadcast(&walk->cond);
+		pthread_mutex_unlock(&walk->lock);
+	}
+	return (NULL);
+}
+
+/**
+ * Walks the given roots recursively with a pool of walker threads.
+ * Regular files are streamed to 'on_file' as soon as they are discovered, which
+ * takes ownership of the entry path. Only the directories still to be read are
+ * kept in memory. Roots that are regular files are reported directly.
+ *
+ * @param args The request walking the tree (error messages).
+ * @param roots Array of paths to walk.
+ * @param count Number of paths in 'roots'.
+ * @param flags WALK_STAT to get the size of every file reported.
+ * @param on_file Callback invoked (possibly concurrently) for each regular file.
+ * @param data Opaque pointer passed back to the callback.
+ */
+void	walk_tree(const args_t *args, char **roots, int count, int flags, walk_callback_t on_file, void *data)
+{
+	walk_t		walk = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, flags, on_file, data, args};
+	pthread_t	threads[ENGINE_MAX_THREADS];
+	int			num_threads = 0;
+	struct statx	st;
+
+	for (int i = 0; i < count; i++)
+	{
+		char	*path = strdup(roots[i]);
+		if (!path || statx(AT_FDCWD, roots[i], 0, STATX_TYPE | STATX_SIZE | STATX_INO, &st) == -1)
+		{
+			print_error(args, roots[i], strerror(errno));
+			free(path);
+			continue;
+		}
+		if (S_ISDIR(st.stx_mode))
+			walk_push(&walk, path);
+		else
+		{
+			walk_entry_t	file = {path, st.stx_size, st.stx_ino};
+			on_file(&file, data);
+		}
+	}
+
+	int	wanted = engine_threads();
+	while (num_threads < wanted && walk.pending)
+	{
+		if (pthread_create(&threads[num_threads], NULL, walk_worker, &walk) != 0)
+			break;
+		num_threads++;
+	}
+	if (num_threads == 0)
+		walk_worker(&walk);
+	for (int i = 0; i < num_threads; i++)
+		pthread_join(threads[i], NULL);
+	pthread_cond_destroy(&walk.cond);
+	pthread_mutex_destroy(&walk.lock);
+}
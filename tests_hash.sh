@@ -52,6 +52,38 @@ acbd18db4cc2f85cedef654fccc4a4d8
 53d53ea94217b259c11a5a2d104ec58a'
 run_test 'echo "" | ./ft_ssl md5 -r -q' '68b329da9893e34099c7d8ad5cb9c940'
 run_test './ft_ssl md5 long_file' 'MD5 (long_file) = 299f4552f22c85e81c13972fa0faca06'
+run_test './ft_ssl sha256 -q -s "" -s abc -s foo -s xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx -s bar' 'e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855
+ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad
+2c26b46b68ffc68ff99b453c1d30413413422d706483bfa0f98a5e886266e7ae
+42f2d97335669f86846b721a8aa58551a46564eaf6977e3b4836d4645e3e3ed2
+fcde2b2edba56bf408601fb721fe9b5c338d10ee429ea04fae5511b68fbf8fb9'
+printf "foo" > prefix
+run_test './ft_ssl md5 --prefix-file prefix -s bar' 'MD5 ("bar") = 3858f62230ac3c915f300c664312c63f'
+printf "%0100d" 0 | tr 0 x > prefix
+run_test './ft_ssl sha256 -r --prefix-file prefix -s bar' '0d32ecbde118049eba62db4a659b78ca06f23fa59001372227b8129ed52f04a2 "bar"'
+rm prefix
+run_test 'printf "abc\r\n\nfoo" | ./ft_ssl sha256 --per-line' 'ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad
+e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855
+2c26b46b68ffc68ff99b453c1d30413413422d706483bfa0f98a5e886266e7ae'
+run_test 'printf "a,abc,x\nb\nc,foo\n" | ./ft_ssl md5 --field 2' '900150983cd24fb0d6963f7d28e17f72
+d41d8cd98f00b204e9800998ecf8427e
+acbd18db4cc2f85cedef654fccc4a4d8'
+run_test 'printf "x;bar\n" | ./ft_ssl md5 --field 2 -d ";"' '37b51d194a7513e45b56f6524f2d51f2'
+printf "\0\0\0\3abc\0\0\0\0" > records
+run_test './ft_ssl md5 --batch < records | od -An -tx1 | tr -d " \n"' '900150983cd24fb0d6963f7d28e17f72d41d8cd98f00b204e9800998ecf8427e'
+head -c 6 records > truncated
+run_test './ft_ssl sha256 --batch < truncated 2>&1; echo $?' 'ft_ssl: Error: truncated record at the end of the input (6 bytes).
+1'
+run_test './ft_ssl md5 --batch < src 2>&1; echo $?' 'ft_ssl: md5: stdin: Is a directory
+1'
+rm records truncated
+cp file llllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllll
+run_test 'tar --format=pax -cf - file llllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllll | ./ft_ssl md5 -r --tar' '53d53ea94217b259c11a5a2d104ec58a file
+53d53ea94217b259c11a5a2d104ec58a llllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllll'
+run_test 'tar --format=gnu -cf - llllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllll | head -c 1000 | ./ft_ssl md5 --tar 2>&1' 'ft_ssl: md5: stdin: unexpected end of archive'
+run_test './ft_ssl md5 --tar < src 2>&1; echo $?' 'ft_ssl: md5: stdin: Is a directory
+1'
+rm llllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllll
 
 echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
 echo -e "-                                                           \033[36mEND OF SUBJECT TESTS\033[0m                                                                -"
@@ -101,6 +133,372 @@ echo "--------------------------------------------------------------------------
 echo -e "-                                                          \033[36mEND OF WHIRLPOOL TESTS\033[0m                                                               -"
 echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
 
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                             \033[36mRECURSIVE TESTS\033[0m                                                                   -"
+
+mkdir -p tree/sub/deep
+cp file tree/file
+cp long_file tree/sub/long_file
+echo "42 is nice" > tree/sub/deep/nice
+run_test './ft_ssl md5 -r -R tree | sort' '299f4552f22c85e81c13972fa0faca06 tree/sub/long_file
+35f1d6de0302e2086a4e472266efb3a9 tree/sub/deep/nice
+53d53ea94217b259c11a5a2d104ec58a tree/file'
+run_test './ft_ssl md5 -R file' 'MD5 (file) = 53d53ea94217b259c11a5a2d104ec58a'
+run_test 'printf "tree/file\\0tree/sub/long_file\\0" | ./ft_ssl md5 -r -0 --files-from - | sort' '299f4552f22c85e81c13972fa0faca06 tree/sub/long_file
+53d53ea94217b259c11a5a2d104ec58a tree/file'
+printf "tree/file\ntree/sub/deep/nice\n" > file_list
+run_test './ft_ssl md5 -r --files-from file_list | sort' '35f1d6de0302e2086a4e472266efb3a9 tree/sub/deep/nice
+53d53ea94217b259c11a5a2d104ec58a tree/file'
+run_test './ft_ssl md5 -r --disk-order -R tree | sort' '299f4552f22c85e81c13972fa0faca06 tree/sub/long_file
+35f1d6de0302e2086a4e472266efb3a9 tree/sub/deep/nice
+53d53ea94217b259c11a5a2d104ec58a tree/file'
+head -c 9000000 /dev/zero > tree/sub/large_file
+run_test './ft_ssl md5 -r --disk-order -R tree | sort' '1dfe5e6e4defff78eb0b5217313a6940 tree/sub/large_file
+299f4552f22c85e81c13972fa0faca06 tree/sub/long_file
+35f1d6de0302e2086a4e472266efb3a9 tree/sub/deep/nice
+53d53ea94217b259c11a5a2d104ec58a tree/file'
+rm tree/sub/large_file
+rm file_list
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                          \033[36mEND OF RECURSIVE TESTS\033[0m                                                               -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                               \033[36mCHECK TESTS\033[0m                                                                     -"
+
+./ft_ssl sha256 -r file long_file > manifest
+run_test './ft_ssl sha256 -c manifest | sort' 'file: OK
+long_file: OK'
+echo "53d53ea94217b259c11a5a2d104ec58a  file" > manifest
+echo "MD5 (long_file) = 00000000000000000000000000000000" >> manifest
+run_test './ft_ssl md5 -c manifest 2>/dev/null | sort' 'file: OK
+long_file: FAILED'
+run_test './ft_ssl md5 -c manifest 2>&1 >/dev/null; echo $?' 'ft_ssl: WARNING: 1 computed checksum did NOT match
+1'
+run_test './ft_ssl md5 -q -c manifest 2>/dev/null' 'long_file: FAILED'
+rm manifest
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mEND OF CHECK TESTS\033[0m                                                                 -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                               \033[36mDEDUP TESTS\033[0m                                                                     -"
+
+mkdir -p dups/sub
+cp long_file dups/long_1
+cp long_file dups/sub/long_2
+cp file dups/file
+echo "And above all." > dups/same_size
+run_test './ft_ssl dedup -a md5 dups' '299f4552f22c85e81c13972fa0faca06 dups/long_1
+299f4552f22c85e81c13972fa0faca06 dups/sub/long_2'
+rm -rf dups
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mEND OF DEDUP TESTS\033[0m                                                                 -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                               \033[36mSTORE TESTS\033[0m                                                                     -"
+
+cp long_file long_copy
+run_test './ft_ssl store --cas cas -a md5 -r long_file | sort' '299f4552f22c85e81c13972fa0faca06 long_file'
+run_test './ft_ssl store --cas cas -a md5 -q long_copy file | sort' '299f4552f22c85e81c13972fa0faca06
+53d53ea94217b259c11a5a2d104ec58a'
+run_test '(cd cas && find . -type f | sort)' './29/9f4552f22c85e81c13972fa0faca06
+./53/d53ea94217b259c11a5a2d104ec58a'
+run_test 'cmp long_file cas/29/9f4552f22c85e81c13972fa0faca06 && echo identical' 'identical'
+rm -rf cas long_copy
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mEND OF STORE TESTS\033[0m                                                                 -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                               \033[36mINDEX TESTS\033[0m                                                                     -"
+
+./ft_ssl md5 -r file > known
+echo "acbd18db4cc2f85cedef654fccc4a4d8 foo" >> known
+./ft_ssl index build -a md5 -o known.idx known
+run_test 'printf "acbd18db4cc2f85cedef654fccc4a4d8 a\n299f4552f22c85e81c13972fa0faca06 b\n" | ./ft_ssl index lookup known.idx' 'acbd18db4cc2f85cedef654fccc4a4d8 a'
+run_test './ft_ssl md5 -r --index known.idx -s foo -s bar file long_file' 'acbd18db4cc2f85cedef654fccc4a4d8 "foo"
+53d53ea94217b259c11a5a2d104ec58a file'
+rm known known.idx
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mEND OF INDEX TESTS\033[0m                                                                 -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                               \033[36mCRACK TESTS\033[0m                                                                     -"
+
+printf "hello\nfoo\nabc\nletmein\nxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\nbar\n" > words
+printf "acbd18db4cc2f85cedef654fccc4a4d8\n900150983cd24fb0d6963f7d28e17f72\n" > targets
+run_test './ft_ssl crack -w words targets 2>/dev/null | sort' '900150983cd24fb0d6963f7d28e17f72:abc
+acbd18db4cc2f85cedef654fccc4a4d8:foo'
+run_test './ft_ssl sha256 -q -s letmein | ./ft_ssl crack -a sha256 -w words 2>/dev/null' '1c8bfe8f801d79745c4631d09fff36c82aa37fc4cce4fc946683d7b336b63032:letmein'
+run_test 'echo 1198000c11968f9368e02d6da57ec147 | ./ft_ssl crack -w words 2>/dev/null' '1198000c11968f9368e02d6da57ec147:xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx'
+run_test 'echo 0123456789abcdef0123456789abcdef | ./ft_ssl crack -w words 2>/dev/null; echo $?' '1'
+rm words targets
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mEND OF CRACK TESTS\033[0m                                                                 -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                                \033[36mHMAC TESTS\033[0m                                                                     -"
+
+run_test './ft_ssl hmac -a md5 -k key -s foo' 'HMAC-MD5 ("foo") = ee953a87acb32cc061184a8b973f6b34'
+run_test './ft_ssl hmac -k key -r -s "The quick brown fox jumps over the lazy dog"' 'f7bc83f430538424b13298e6aa6fb143ef4d59a14946175997479dbc2d1a3cd8 "The quick brown fox jumps over the lazy dog"'
+run_test 'printf "a\nb\n" | ./ft_ssl hmac -k k --lines -' '78da91511e675587f5b9df78bedebaf5560da2abb88162ee875dcdf744951d9e
+2fb39898cf6b5cadbde2377d14dbc7331caaf0825d59106d090deeb785aaa389'
+run_test 'printf abc | ./ft_ssl hmac -q -k kkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkk' 'b58b2b694fdba0dd76da3ebe99174f728d327560f36ece224e90867972479922'
+run_test 'head -c 1000000 /dev/zero | ./ft_ssl hmac -q -k key' 'bfcd05229ceb6ae105a45a73f6a0d23e798ae286b7738ebda46381c2c1029ab2'
+run_test 'printf abc > hmac_order; ./ft_ssl hmac -a md5 -k key nonexist_q hmac_order 2>&1; rm -f hmac_order' 'ft_ssl: md5: nonexist_q: No such file or directory
+HMAC-MD5 (hmac_order) = d2fe98063f876b03193afb49b4979591'
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                             \033[36mEND OF HMAC TESTS\033[0m                                                                 -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                               \033[36mPBKDF2 TESTS\033[0m                                                                    -"
+
+run_test './ft_ssl pbkdf2 -S salt -i 2 -p password' 'PBKDF2-SHA256 ("password") = ae4d0c95af6b46d32d0adff928f06dd02a303f8ef3c251dfd6e2d85a95474c43'
+run_test 'printf "a\nb\nc\nd\ne\n" | ./ft_ssl pbkdf2 -S NaCl -i 100 -l 20 --passwords -' '55aea68a7f18a007a2e64d3ff0d3b78d989adb67
+67779386cdf3678cf7624dfba60e14fa528c30c1
+3b1afbe64e51a149f3d85514786709a4e0e4504c
+a06c2fa4bfd772d5f1076a43e4834cce370dbc34
+8c092402f954178db6b9eb22d31cfc3db2a24e3f'
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mEND OF PBKDF2 TESTS\033[0m                                                                -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                                \033[36mPOW TESTS\033[0m                                                                      -"
+
+run_test 'out=$(./ft_ssl pow -d 12 abc 2>/dev/null); [ "$(./ft_ssl sha256 -q -s "abc${out%% *}")" = "${out#* }" ] && echo "${out#* }" | cut -c1-3' '000'
+run_test 'p=$(printf "%070d" 0); out=$(./ft_ssl pow -a md5 -d 8 $p 2>/dev/null); [ "$(./ft_ssl md5 -q -s "$p${out%% *}")" = "${out#* }" ] && echo "${out#* }" | cut -c1-2' '00'
+run_test './ft_ssl pow -a whirlpool -d 4 prefix 2>/dev/null | cut -c18' '0'
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                              \033[36mEND OF POW TESTS\033[0m                                                                  -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                               \033[36mSERVE TESTS\033[0m                                                                     -"
+
+./ft_ssl serve --socket serve.sock 2>/dev/null &
+sleep 0.3
+run_test 'python3 -c "import socket; s = socket.socket(socket.AF_UNIX); s.connect(\"serve.sock\"); s.sendall(b\"data md5 3\\nabcfile md5 file\\nfile md5 missing\\ndata sha1 0\\n\"); print(s.makefile().read(), end=\"\")"' 'OK 900150983cd24fb0d6963f7d28e17f72
+OK 53d53ea94217b259c11a5a2d104ec58a
+ERR No such file or directory
+ERR invalid algorithm'
+run_test 'python3 -c "import socket, os, array; s = socket.socket(socket.AF_UNIX); s.connect(\"serve.sock\"); fd = os.memfd_create(\"ring\"); os.ftruncate(fd, 4096); f = s.makefile(); s.sendall(b\"shm\\n\"); print(f.readline(), end=\"\"); s.sendmsg([b\"shm\\nquit\\n\"], [(socket.SOL_SOCKET, socket.SCM_RIGHTS, array.array(\"i\", [fd]))]); print(f.read(), end=\"\")"' 'ERR no memfd received with the request
+ERR shared memory region must be sealed with F_SEAL_SHRINK'
+cat > shm_test.py << 'EOF'
+import array, fcntl, mmap, os, socket, struct, sys, time
+
+ENTRIES, SQ, CQ, DATA = 4, 320, 448, 768
+fd = os.memfd_create("ring", os.MFD_ALLOW_SEALING)
+os.ftruncate(fd, 4096)
+fcntl.fcntl(fd, fcntl.F_ADD_SEALS, fcntl.F_SEAL_SHRINK)
+m = mmap.mmap(fd, 4096)
+struct.pack_into("<IIIIQQQQ", m, 0, 0x4d485346, 1, ENTRIES, 0, SQ, CQ, DATA, 64)
+m[DATA:DATA + 3] = b"abc"
+m[DATA + 8:DATA + 13] = b"hello"
+for i, (user, off, length, algo) in enumerate([(7, 0, 3, 1), (9, 8, 5, 2), (11, 60, 100, 1)]):
+    struct.pack_into("<QQQII", m, SQ + i * 32, user, off, length, algo, 0)
+struct.pack_into("<I", m, 128, 3)
+s = socket.socket(socket.AF_UNIX)
+s.connect(sys.argv[1])
+s.sendmsg([b"shm\n"], [(socket.SOL_SOCKET, socket.SCM_RIGHTS, array.array("i", [fd]))])
+print(s.makefile().readline(), end="")
+def complete(count):
+    deadline = time.time() + 5
+    while struct.unpack_from("<I", m, 256)[0] < count and time.time() < deadline:
+        time.sleep(0.01)
+
+complete(3)
+# Rewriting the layout once attached must not move the rings of the session
+struct.pack_into("<IIIIQQQQ", m, 0, 0x4d485346, 1, 65536, 0, 1 << 40, 1 << 40, 1 << 40, 1 << 40)
+struct.pack_into("<QQQII", m, SQ + 3 * 32, 13, 0, 3, 2, 0)
+struct.pack_into("<I", m, 128, 4)
+complete(4)
+for i in range(struct.unpack_from("<I", m, 256)[0]):
+    user, status, size = struct.unpack_from("<QiI", m, CQ + i * 80)
+    digest = m[CQ + i * 80 + 16:CQ + i * 80 + 16 + size].hex()
+    print(user, status, *([digest] if status == 0 else []))
+EOF
+run_test 'python3 shm_test.py serve.sock' 'OK shm
+7 0 900150983cd24fb0d6963f7d28e17f72
+9 0 2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824
+11 34
+13 0 ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad'
+run_test 'python3 -c "import socket; s = socket.socket(socket.AF_UNIX); s.connect(\"serve.sock\"); s.sendall(b\"execute md5 -q -s abc\nexecute md4 -s x\nexecute md5 -R .\nexecute sha256 -r file\nquit\n\"); print(s.makefile().read(), end=\"\")"' "EXEC 0 33
+900150983cd24fb0d6963f7d28e17f72
+EXEC 1 77
+ft_ssl: Error: 'md4' is an invalid algorithm (use md5, sha256 or whirlpool).
+EXEC 1 118
+ft_ssl: Error: -R, --files-from, --disk-order, -c, --per-line, --tar, --batch and -p are not available in serve mode.
+EXEC 0 70
+$(./ft_ssl sha256 -r file)"
+run_test 'python3 -c "import socket; s = socket.socket(socket.AF_UNIX); s.connect(\"serve.sock\"); s.sendall(b\"data md5 3\nabcdata md5 10\nabc\"); s.shutdown(socket.SHUT_WR); print(s.makefile().read(), end=\"\")"' 'OK 900150983cd24fb0d6963f7d28e17f72
+ERR truncated request'
+kill %1
+wait
+run_test 'ls serve.sock 2>&1 | grep -c "No such file"' '1'
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                             \033[36mEND OF SERVE TESTS\033[0m                                                                 -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mINTERACTIVE TESTS\033[0m                                                                  -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+run_test 'printf "execute md5 -s foo\nexecute sha256 -q -s bar\nexecute md5 -r -s baz\nexit\n" | ./ft_ssl | tail -n +3' 'ft_ssl> MD5 ("foo") = acbd18db4cc2f85cedef654fccc4a4d8
+ft_ssl> fcde2b2edba56bf408601fb721fe9b5c338d10ee429ea04fae5511b68fbf8fb9
+ft_ssl> 73feffa4b7f6bb68e44cf984c85f6e88 "baz"
+ft_ssl> '
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                          \033[36mEND OF INTERACTIVE TESTS\033[0m                                                               -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                              \033[36mENCODING TESTS\033[0m                                                                   -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+run_test './ft_ssl sha256 --base64 -s abc' 'SHA256 ("abc") = ungWv48Bz+pBQUDeXa4iI7ADYaOWF3qctBD/YfIAFa0='
+run_test './ft_ssl md5 -r --base64 -s a' 'DMF1ucDxtqgxw5niaXcmYQ== "a"'
+run_test './ft_ssl md5 --base64 -q file' "$(openssl md5 -binary file | base64)"
+run_test './ft_ssl whirlpool --binary -s abc | xxd -p | tr -d "\n"' '4e2448a4c6f486bb16b6562c73b4020bf3043e3a731bce721ae1b303d97e6d4c7181eebdb6c57e277d0e34957114cbd6c797fc9d95d8b582d225292076d4eef5'
+run_test 'printf "a\nb\n" | ./ft_ssl md5 --per-line --binary | xxd -p | tr -d "\n"' '0cc175b9c0f1b6a831c399e26977266192eb5ffee6ae2fec3ad71c777531578f'
+run_test './ft_ssl md5 --binary --base64 -s a 2>&1' "ft_ssl: Error: '--binary' and '--base64' cannot be used together."
+run_test 'printf abc > binary_err; ./ft_ssl md5 --binary nonexist_b binary_err 2>/dev/null | xxd -p; ./ft_ssl md5 --binary nonexist_b binary_err 2>&1 >/dev/null; rm -f binary_err' '900150983cd24fb0d6963f7d28e17f72
+ft_ssl: md5: nonexist_b: No such file or directory'
+run_test './ft_ssl md5 --binary -R src 2>&1; ./ft_ssl md5 --files-from - --binary < /dev/null 2>&1' "ft_ssl: Error: '--binary' cannot be used with '-p', '-R', '--files-from' or '--disk-order'.
+ft_ssl: Error: '--binary' cannot be used with '-p', '-R', '--files-from' or '--disk-order'."
+run_test './ft_ssl md5 --binary --disk-order Makefile 2>&1; echo $?' "ft_ssl: Error: '--binary' cannot be used with '-p', '-R', '--files-from' or '--disk-order'.
+1"
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mEND OF ENCODING TESTS\033[0m                                                              -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                              \033[36mLIBRARY TESTS\033[0m                                                                    -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+cat > lib_test.c << 'EOF'
+#include <stdio.h>
+#include <string.h>
+#include "libftssl.h"
+
+/* Prints the one-shot, streaming and batch digests of argv[2] with algorithm argv[1] */
+int	main(int ac, char **av)
+{
+	ftssl_algo_t	algo = ac == 3 ? ftssl_algo_by_name(av[1]) : 0;
+	size_t			size = ftssl_digest_size(algo);
+	uint8_t			digests[3][FTSSL_MAX_DIGEST_SIZE];
+	uint8_t			*outputs[2] = {digests[2], digests[2]};
+	const uint8_t	*msgs[2] = {(const uint8_t *)av[2], (const uint8_t *)av[2]};
+	size_t			lens[2] = {strlen(av[2]), strlen(av[2])};
+	char			hex[FTSSL_MAX_DIGEST_SIZE * 2 + 1] = {0};
+	ftssl_ctx_t		ctx;
+
+	if (ftssl_digest(algo, av[2], lens[0], digests[0]) || ftssl_init(&ctx, algo)
+		|| ftssl_digest_batch(algo, msgs, lens, outputs, 2))
+		return (1);
+	for (size_t i = 0; i < lens[0]; i++)
+		ftssl_update(&ctx, av[2] + i, 1);
+	ftssl_final(&ctx, digests[1]);
+	for (int i = 0; i < 3; i++)
+	{
+		ftssl_hex(digests[i], size, hex);
+		printf("%s\n", hex);
+	}
+	return (0);
+}
+EOF
+
+run_test 'gcc -Wall -Wextra -Werror lib_test.c -I includes -L. -l:libftssl.a -o lib_test && ./lib_test sha256 abc | uniq' "$(printf abc | sha256sum | cut -d' ' -f1)"
+run_test 'gcc -Wall -Wextra -Werror lib_test.c -I includes -L. -lftssl -o lib_test && LD_LIBRARY_PATH=. ./lib_test md5 "$(cat file)" | uniq' "$(printf "$(cat file)" | md5sum | cut -d' ' -f1)"
+run_test 'LD_LIBRARY_PATH=. ./lib_test sha512 abc; echo $?' '1'
+run_test 'nm -g --defined-only libftssl.a | awk "NF == 3 && \$3 !~ /^ftssl_/" | wc -l' '0'
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mEND OF LIBRARY TESTS\033[0m                                                               -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                              \033[36mSCRIPT TESTS\033[0m                                                                     -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+printf "# hashes\nexecute md5 -s foo\n\nexecute sha256 -q -s bar\nexecute md4 -s x\nexecute md5 -r file\nexecute md5 -q -s baz\nexit\nexecute md5 -s never\n" > script.txt
+
+run_test './ft_ssl --script script.txt' 'MD5 ("foo") = acbd18db4cc2f85cedef654fccc4a4d8
+fcde2b2edba56bf408601fb721fe9b5c338d10ee429ea04fae5511b68fbf8fb9
+ft_ssl: Error: '"'"'md4'"'"' is an invalid algorithm (use md5, sha256 or whirlpool).
+'"$(md5sum file | cut -d' ' -f1)"' file
+73feffa4b7f6bb68e44cf984c85f6e88'
+
+run_test 'printf "execute md5 -q -s a\nexecute md5 -q -s b\nexecute md5 -q -s a\n" | ./ft_ssl --script -' '0cc175b9c0f1b6a831c399e269772661
+92eb5ffee6ae2fec3ad71c777531578f
+0cc175b9c0f1b6a831c399e269772661'
+
+run_test 'seq 1 3000 | sed "s/^/execute md5 -q -s /" | ./ft_ssl --script - | md5sum | cut -d" " -f1' "$(for i in $(seq 1 3000); do printf "$i" | md5sum | cut -d' ' -f1; done | md5sum | cut -d' ' -f1)"
+
+run_test './ft_ssl --script script.txt > /dev/null; echo $?' '1'
+run_test 'printf "execute md5 -x\nexecute md5 -q -s a\nexecute sha1 -s a\nexecute md5 -s\n" | ./ft_ssl --script - 2>&1' "ft_ssl: Error: '-x' is an invalid flag.
+0cc175b9c0f1b6a831c399e269772661
+ft_ssl: Error: 'sha1' is an invalid algorithm (use md5, sha256 or whirlpool).
+ft_ssl: Error: '-s' expect a string after it."
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                            \033[36mEND OF SCRIPT TESTS\033[0m                                                                -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+echo
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                               \033[36mIMPL TESTS\033[0m                                                                      -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
+run_test 'for i in scalar sse2 shani auto; do ./ft_ssl --impl $i sha256 -q -s abc 2>/dev/null; done | sort -u' 'ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad'
+run_test 'for i in scalar sse2 shani auto; do out=$(./ft_ssl --impl $i md5 -q -s abc -s "" -s "The quick brown fox" 2>/dev/null) && echo "$out" | md5sum; done | sort -u' "$(printf '900150983cd24fb0d6963f7d28e17f72\nd41d8cd98f00b204e9800998ecf8427e\na2004f37730b9445670a738fa0fc9ee5\n' | md5sum)"
+run_test 'for i in scalar sse2 shani; do out=$(./ft_ssl --impl $i pbkdf2 -S salt -i 100 -p a -p b -p c -p d -p e -q 2>/dev/null) && echo "$out" | md5sum; done | sort -u | wc -l' '1'
+run_test 'FT_SSL_IMPL=scalar ./ft_ssl bench -n 10 -l 8 -a md5 | head -1' 'implementation: scalar (multi-lane kernels: scalar, whirlpool: scalar)'
+run_test './ft_ssl --impl foo md5 -s abc 2>&1; echo $?' "ft_ssl: Error: 'foo' is an invalid implementation (use auto, scalar, sse2 or shani).
+1"
+run_test 'FT_SSL_IMPL=foo ./ft_ssl md5 -q -s abc 2>&1' "ft_ssl: warning: FT_SSL_IMPL='foo' is not available, using auto.
+900150983cd24fb0d6963f7d28e17f72"
+run_test 'FT_SSL_IMPL=foo LD_LIBRARY_PATH=. ./lib_test md5 abc 2>&1 | uniq' '900150983cd24fb0d6963f7d28e17f72'
+
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+echo -e "-                                                             \033[36mEND OF IMPL TESTS\033[0m                                                                 -"
+echo "-------------------------------------------------------------------------------------------------------------------------------------------------"
+
 # Clean up
+rm shm_test.py
+rm script.txt
+rm lib_test lib_test.c
 rm file
 rm long_file
+rm -rf tree